@@ -49,12 +49,384 @@
 //
 
 #include "ARCE.h"
+#ifdef ARCE_HOST
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Get the time since the program start in microseconds (host builds), as the Arduino micros() function. Wraps around after about 71 minutes.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+uint32_t micros() {
+  
+  static struct timespec startTime = { 0, 0 }; // Time of the first call (monotonic clock).
+  struct timespec now;                         // Current time (monotonic clock).
+  
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  if (startTime.tv_sec == 0 && startTime.tv_nsec == 0) startTime = now;
+  return (uint32_t)((now.tv_sec - startTime.tv_sec) * 1000000 + (now.tv_nsec - startTime.tv_nsec) / 1000);
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Update a CRC-CCITT with a given byte (host builds). Same result as the avr-libc _crc_ccitt_update() function, so the frame hashes of a replay 
+// match the device ones.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+uint16_t _crc_ccitt_update(uint16_t crc, uint8_t data) {
+  
+  data ^= crc & 0xFF;
+  data ^= data << 4;
+  return (((uint16_t)data << 8) | (crc >> 8)) ^ (uint8_t)(data >> 4) ^ ((uint16_t)data << 3);
+}
+#endif
 
 // ------------------------------------------------------------------------------------------------------------------------------------------------------
 // ARCE Player Class constructor.
 // ------------------------------------------------------------------------------------------------------------------------------------------------------
 ARCEPlayer::ARCEPlayer() { }
 
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// ARCE Statistics Class constructor.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+ARCEStats::ARCEStats() { }
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// ARCE Ray Query Class constructor.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+ARCERayQuery::ARCERayQuery() { }
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// ARCE Entities Class constructor.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+ARCEEntities::ARCEEntities() {
+  
+  for (ARCEEntityIndex entity=0; entity<ARCE_MAX_ENTITIES; entity++) flags[entity] = 0;
+  for (uint16_t bucket=0; bucket<ENTITY_HASH_SIZE; bucket++) firstInBucket[bucket] = ENTITY_NONE;
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Add an entity at a given position. The entity does not move until its velocity is set. Returns its index or ENTITY_NONE if the store is full.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+ARCEEntityIndex ARCEEntities::add(int16_t x, int16_t y, uint8_t radius) {
+  
+  ARCEEntityIndex entity = 0; // Index of the new entity.
+  
+  // Find a free slot
+  while (entity < ARCE_MAX_ENTITIES && (flags[entity] & ENTITY_ACTIVE)) entity++;
+  if (entity == ARCE_MAX_ENTITIES) return ENTITY_NONE;
+  if (entity >= count) count = entity + 1;
+  
+  this->x[entity] = x;
+  this->y[entity] = y;
+  this->radius[entity] = radius;
+  velocityX[entity] = 0;
+  velocityY[entity] = 0;
+  flags[entity] = ENTITY_ACTIVE;
+  blockX[entity] = x >> DIVIDE_BY_BLOCK_SIZE;
+  blockY[entity] = y >> DIVIDE_BY_BLOCK_SIZE;
+  link(entity);
+  
+  return entity;
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Remove a given entity.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+void ARCEEntities::remove(ARCEEntityIndex entity) {
+  
+  if (!(flags[entity] & ENTITY_ACTIVE)) return;
+  
+  unlink(entity);
+  flags[entity] = 0;
+  
+  // Loops over the entities stop after the last active entity
+  while (count > 0 && !(flags[count - 1] & ENTITY_ACTIVE)) count--;
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Move a given entity to a given position. The spatial hash is only updated when the entity goes to another block.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+void ARCEEntities::setPosition(ARCEEntityIndex entity, int16_t x, int16_t y) {
+  
+  uint8_t newBlockX = x >> DIVIDE_BY_BLOCK_SIZE; // X position of the new block of the entity (world map coordinates).
+  uint8_t newBlockY = y >> DIVIDE_BY_BLOCK_SIZE; // Y position of the new block of the entity (world map coordinates).
+  
+  this->x[entity] = x;
+  this->y[entity] = y;
+  
+  if (newBlockX != blockX[entity] || newBlockY != blockY[entity]) {
+    
+    unlink(entity);
+    blockX[entity] = newBlockX;
+    blockY[entity] = newBlockY;
+    link(entity);
+  }
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Find the entities whose position is not farther than a given distance from a given position. Only the spatial hash buckets of the blocks around the 
+// position are read. The indexes of the entities found are saved in the entities array (up to maxEntities). Returns the number of entities found.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+ARCEEntityIndex ARCEEntities::findEntities(int16_t x, int16_t y, uint16_t distance, ARCEEntityIndex *entities, ARCEEntityIndex maxEntities) {
+  
+  int16_t firstBlockX = (x - (int16_t)distance) >> DIVIDE_BY_BLOCK_SIZE; // X position of the first block around the position (world map coordinates).
+  int16_t firstBlockY = (y - (int16_t)distance) >> DIVIDE_BY_BLOCK_SIZE; // Y position of the first block around the position (world map coordinates).
+  int16_t lastBlockX = (x + (int16_t)distance) >> DIVIDE_BY_BLOCK_SIZE;  // X position of the last block around the position (world map coordinates).
+  int16_t lastBlockY = (y + (int16_t)distance) >> DIVIDE_BY_BLOCK_SIZE;  // Y position of the last block around the position (world map coordinates).
+  uint32_t distanceSquare = (uint32_t)distance * distance;              // Square of the distance (world coordinates).
+  int32_t deltaX = 0;                                                   // X distance between the position and an entity (world coordinates).
+  int32_t deltaY = 0;                                                   // Y distance between the position and an entity (world coordinates).
+  ARCEEntityIndex entity;                                               // Current entity of a spatial hash bucket.
+  ARCEEntityIndex entitiesCount = 0;                                    // Number of entities found.
+  
+  if (firstBlockX < 0) firstBlockX = 0;
+  if (firstBlockY < 0) firstBlockY = 0;
+  if (lastBlockX > 255) lastBlockX = 255;
+  if (lastBlockY > 255) lastBlockY = 255;
+  
+  for (int16_t currentBlockY=firstBlockY; currentBlockY<=lastBlockY; currentBlockY++) {
+    
+    for (int16_t currentBlockX=firstBlockX; currentBlockX<=lastBlockX; currentBlockX++) {
+      
+      entity = firstInBucket[getBucket(currentBlockX, currentBlockY)];
+      
+      while (entity != ENTITY_NONE) {
+        
+        // Several blocks share a bucket : only the entities of the current block are checked (each entity is then found once)
+        if (blockX[entity] == currentBlockX && blockY[entity] == currentBlockY) {
+          
+          deltaX = this->x[entity] - x;
+          deltaY = this->y[entity] - y;
+          if ((uint32_t)(deltaX * deltaX + deltaY * deltaY) <= distanceSquare) {
+            
+            if (entitiesCount == maxEntities) return entitiesCount;
+            entities[entitiesCount++] = entity;
+          }
+        }
+        entity = nextInBucket[entity];
+      }
+    }
+  }
+  
+  return entitiesCount;
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Get the spatial hash bucket of a given block. The 9 blocks around any block always use different buckets : their offsets (X + Y * 7) go from -8 to 8,
+// so they are different modulo any ENTITY_HASH_SIZE of 32 or more (checked in ARCE.h).
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+uint16_t ARCEEntities::getBucket(uint8_t blockX, uint8_t blockY) {
+  
+  return (blockX + blockY * 7) & (ENTITY_HASH_SIZE - 1);
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Link a given entity in the spatial hash bucket of its block.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+void ARCEEntities::link(ARCEEntityIndex entity) {
+  
+  uint16_t bucket = getBucket(blockX[entity], blockY[entity]); // Spatial hash bucket of the entity.
+  
+  nextInBucket[entity] = firstInBucket[bucket];
+  firstInBucket[bucket] = entity;
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Unlink a given entity from its spatial hash bucket. Buckets are short, so they are simply linked in one direction.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+void ARCEEntities::unlink(ARCEEntityIndex entity) {
+  
+  ARCEEntityIndex *link = firstInBucket + getBucket(blockX[entity], blockY[entity]); // Link to the current entity of the bucket.
+  
+  while (*link != entity) link = nextInBucket + *link;
+  *link = nextInBucket[entity];
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// ARCE Replay Class constructor.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+ARCEReplay::ARCEReplay() { }
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Start recording the player input in a given RAM array. The recording stops (REPLAY_DONE) when the array is full.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+void ARCEReplay::record(uint8_t *session, uint16_t sessionMaxSize) {
+  
+  *this = ARCEReplay();
+  recordedSession = session;
+  sessionSize = sessionMaxSize;
+  mode = REPLAY_RECORD;
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Start playing a given session. Each frame is checked against goldenHashes when it is given. The frameHashes array and the render time budget are
+// kept, so the golden hashes of a session can be made by playing it with a frameHashes array. The session and the golden hashes are assets : they
+// are read from the flash memory (PROGMEM), or from the RAM with ARCE_ASSETS_IN_RAM.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+void ARCEReplay::play(const uint8_t *session, uint16_t sessionSize, const uint16_t *goldenHashes) {
+  
+  uint16_t *frameHashes = this->frameHashes;         // Frame hashes array to keep.
+  uint16_t frameHashesSize = this->frameHashesSize;  // Frame hashes array size to keep.
+  uint32_t renderBudgetMicros = this->renderBudgetMicros; // Render time budget to keep.
+  
+  *this = ARCEReplay();
+  this->frameHashes = frameHashes;
+  this->frameHashesSize = frameHashesSize;
+  this->renderBudgetMicros = renderBudgetMicros;
+  playedSession = session;
+  this->sessionSize = sessionSize;
+  this->goldenHashes = goldenHashes;
+  mode = REPLAY_PLAY;
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Stop recording or playing. The recorded session and the results are kept.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+void ARCEReplay::stop() {
+  
+  mode = REPLAY_DONE;
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Tells if all the played frames matched their golden hash and the render time budget.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+bool ARCEReplay::passed() {
+  
+  return failedFrames == 0 && overBudgetFrames == 0;
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Get the size of the recorded session (bytes).
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+uint16_t ARCEReplay::getSessionSize() {
+  
+  return runFrames ? sessionPos + 1 : sessionPos;
+}
+
+#ifndef ARCE_HOST
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Print the recorded session and the frame hashes over Serial, as C++ arrays which can be pasted in a sketch and played with play().
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+void ARCEReplay::printSession() {
+  
+  uint16_t hashCount = frame < frameHashesSize ? frame : frameHashesSize; // Number of frame hashes to print.
+  
+  if (recordedSession) {
+    
+    Serial.println(F("PROGMEM const uint8_t session[] = {"));
+    for (uint16_t pos=0; pos<getSessionSize(); pos++) {
+      
+      Serial.print(F("0x"));
+      Serial.print(recordedSession[pos], HEX);
+      Serial.println(pos + 1 < getSessionSize() ? F(",") : F(""));
+    }
+    Serial.println(F("};"));
+  }
+  
+  if (frameHashes) {
+    
+    Serial.println(F("PROGMEM const uint16_t goldenHashes[] = {"));
+    for (uint16_t hash=0; hash<hashCount; hash++) {
+      
+      Serial.print(F("0x"));
+      Serial.print(frameHashes[hash], HEX);
+      Serial.println(hash + 1 < hashCount ? F(",") : F(""));
+    }
+    Serial.println(F("};"));
+  }
+}
+#endif
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Record or play the input of the next frame. When recording, the input set by the game is added to the session. When playing, the input of the
+// session replaces the input set by the game, and the session ends (REPLAY_DONE) after its last run.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+void ARCEReplay::readInput(ARCEPlayer *player) {
+  
+  uint8_t run = 0; // Current run of the session.
+  
+  if (mode == REPLAY_RECORD) {
+    
+    run = REPLAY_RUN(player->moveDir, player->rotDir, 1);
+    
+    // The same input extends the current run, up to REPLAY_RUN_MAX_FRAMES frames
+    if (runFrames && runFrames < REPLAY_RUN_MAX_FRAMES && (recordedSession[sessionPos] & (REPLAY_RUN_MAX_FRAMES - 1)) == run) {
+      
+      recordedSession[sessionPos] += REPLAY_RUN_MAX_FRAMES;
+      runFrames++;
+      return;
+    }
+    if (runFrames) sessionPos++;
+    if (sessionPos == sessionSize) {
+      
+      runFrames = 0;
+      mode = REPLAY_DONE;
+      return;
+    }
+    recordedSession[sessionPos] = run;
+    runFrames = 1;
+  }
+  else if (mode == REPLAY_PLAY) {
+    
+    if (!runFrames) {
+      
+      if (sessionPos == sessionSize) {
+        
+        player->moveDir = PLAYER_MOVE_NONE;
+        player->rotDir = PLAYER_ROTATE_NONE;
+        mode = REPLAY_DONE;
+        return;
+      }
+      runFrames = (ARCE_READ_BYTE(playedSession + sessionPos) >> DIVIDE_BY_REPLAY_RUN_MAX_FRAMES) + 1;
+      sessionPos++;
+    }
+    
+    run = ARCE_READ_BYTE(playedSession + sessionPos - 1);
+    player->moveDir = (int8_t)(run & 3) - 1;
+    player->rotDir = (int8_t)((run >> 2) & 3) - 1;
+    runFrames--;
+  }
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Hash a rendered frame, save the hash in the frameHashes array and check the frame against its golden hash and the render time budget.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+void ARCEReplay::checkFrame(const uint8_t *buffer, uint32_t renderMicros) {
+  
+  uint16_t hash = 0; // Hash of the frame.
+  
+  if (mode != REPLAY_RECORD && mode != REPLAY_PLAY) return;
+  
+  hash = hashFrame(buffer);
+  if (frameHashes && frame < frameHashesSize) frameHashes[frame] = hash;
+  
+  if (mode == REPLAY_PLAY) {
+    
+    if (goldenHashes && ARCE_READ_WORD(goldenHashes + frame) != hash) {
+      
+      if (!failedFrames) firstFailedFrame = frame;
+      failedFrames++;
+    }
+    if (renderBudgetMicros && renderMicros > renderBudgetMicros) overBudgetFrames++;
+  }
+  
+  if (renderMicros > maxRenderMicros) maxRenderMicros = renderMicros;
+  totalRenderMicros += renderMicros;
+  frame++;
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Get the hash (CRC-CCITT) of a screen buffer.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+uint16_t ARCEReplay::hashFrame(const uint8_t *buffer) {
+  
+  uint16_t hash = 0xFFFF; // Hash of the screen buffer.
+  
+  for (uint16_t pos=0; pos<SCREEN_BUFFER_SIZE; pos++) hash = _crc_ccitt_update(hash, buffer[pos]);
+  return hash;
+}
+
 // ------------------------------------------------------------------------------------------------------------------------------------------------------
 // ARCE Engine Class constructor.
 // /!\ Calling Arduboy::start() function in this constructor breaks the device. ARCE::start() is used instead of this constructor /!\
@@ -66,18 +438,151 @@ ARCE::ARCE() { }
 // ------------------------------------------------------------------------------------------------------------------------------------------------------
 void ARCE::start() {
   
+#ifndef ARCE_HOST
   SPI.begin();
   
   // Initialize Arduboy library
   display.start();
   display.setTextSize(1);
+  
+  // Get the Arduboy screen buffer used by the renderer
+  buffer = display.getBuffer();
+#else
+  buffer = screenBuffer;
+#endif
+  
+  // Start the simulation clock
+  lastStepMicros = micros();
 }
 
 // ------------------------------------------------------------------------------------------------------------------------------------------------------
 // Must be called every frame. Can be placed inside the Arduino "loop()" function.
+// The game speed follows the frame rate : step() can be used instead in order to run the simulation at a fixed rate.
 // ------------------------------------------------------------------------------------------------------------------------------------------------------
 void ARCE::update() {
   
+  if (replay) replay->readInput(&player);
+  simulate();
+  render();
+  
+  // Reset player move and rotation for next frame
+  player.moveDir = PLAYER_MOVE_NONE;
+  player.rotDir = PLAYER_ROTATE_NONE;
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Run the simulation ticks elapsed since the last call (fixed timestep), and tell if a frame should be rendered. Can be placed inside the Arduino 
+// "loop()" function instead of update() : 
+//
+//   if (arce.step()) { arce.render(); arce.displayFrame(); }
+//
+// With the clearAfterDisplay option (as in the demo), displayFrame() clears the screen buffer while sending it, so no clear is needed before render().
+// The simulation always runs tickMicros by tickMicros, so the game speed does not depend on the frame rate. When ticks are still late after 
+// SIMULATION_MAX_TICKS ticks (heavy frames), the simulation is behind : the frame is skipped and the next call catches up. Only one frame is skipped
+// in a row : if the simulation is still behind, the late time is dropped instead of freezing the game. Returns true if at least one tick was run and 
+// the frame is not skipped.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+bool ARCE::step() {
+  
+  uint32_t now = micros(); // Current time (microseconds).
+  uint8_t ticks = 0;       // Number of simulation ticks run by this call.
+  
+  // A recorded or played session runs exactly one tick per frame, so the session does not depend on the frame rate
+  if (replay && (replay->mode == REPLAY_RECORD || replay->mode == REPLAY_PLAY)) {
+    
+    replay->readInput(&player);
+    simulate();
+    player.moveDir = PLAYER_MOVE_NONE;
+    player.rotDir = PLAYER_ROTATE_NONE;
+    lastStepMicros = now;
+    tickAccumulatorMicros = 0;
+    return true;
+  }
+  
+  tickAccumulatorMicros += now - lastStepMicros;
+  lastStepMicros = now;
+  
+  while (tickAccumulatorMicros >= tickMicros && ticks < SIMULATION_MAX_TICKS) {
+    
+    simulate();
+    tickAccumulatorMicros -= tickMicros;
+    ticks++;
+  }
+  
+  if (ticks == 0) return false;
+  
+  // Reset player move and rotation for next ticks
+  player.moveDir = PLAYER_MOVE_NONE;
+  player.rotDir = PLAYER_ROTATE_NONE;
+  
+  // The rendering is skipped (not the simulation) when the simulation is behind. After a skipped frame, the late time is dropped (long pause, very 
+  // slow frames) and the frame is rendered.
+  if (tickAccumulatorMicros >= tickMicros) {
+    
+    if (!frameSkipped) {
+      
+      frameSkipped = true;
+      return false;
+    }
+    tickAccumulatorMicros = 0;
+  }
+  frameSkipped = false;
+  
+  return true;
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Render into a given screen buffer instead of the Arduboy screen buffer : a buffer of SCREEN_BUFFER_SIZE bytes in the Arduboy screen buffer layout, 
+// for offscreen renders or for a host build. The views are only drawn with direct screen buffer writes, so the Arduboy object is not used by render().
+// displayFrame() sends the render target to the display. A 0 target restores the Arduboy screen buffer. Host builds have no Arduboy object : their 
+// default render target is ARCE.screenBuffer.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+void ARCE::setRenderTarget(uint8_t *target) {
+  
+  if (target) buffer = target;
+#ifdef ARCE_HOST
+  else buffer = screenBuffer;
+#else
+  else buffer = display.getBuffer();
+#endif
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Set the rectangle of the render target used by the 3D views (screen coordinates), so a HUD strip can be drawn around them. The projection is 
+// centred on the viewport, and only the rays, rows and pixels of the viewport are rendered. The X position and the width are rounded down to multiples
+// of VIEWPORT_ALIGNMENT, and the viewport is kept inside the screen. The 2D views always use the whole screen.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+void ARCE::setViewport(uint8_t x, uint8_t y, uint8_t width, uint8_t height) {
+  
+  // Keep the viewport inside the screen, with its columns aligned on the slices
+  if (x > SCREEN_WIDTH - VIEWPORT_ALIGNMENT) x = SCREEN_WIDTH - VIEWPORT_ALIGNMENT;
+  x &= ~(VIEWPORT_ALIGNMENT - 1);
+  if (width > SCREEN_WIDTH - x) width = SCREEN_WIDTH - x;
+  width &= ~(VIEWPORT_ALIGNMENT - 1);
+  if (width < VIEWPORT_ALIGNMENT) width = VIEWPORT_ALIGNMENT;
+  if (y > SCREEN_HEIGHT - VIEWPORT_MIN_HEIGHT) y = SCREEN_HEIGHT - VIEWPORT_MIN_HEIGHT;
+  if (height > SCREEN_HEIGHT - y) height = SCREEN_HEIGHT - y;
+  if (height < VIEWPORT_MIN_HEIGHT) height = VIEWPORT_MIN_HEIGHT;
+  
+  // Each ray renders a 2 pixels wide column, and the centre of the viewport is the centre of the projection
+  viewportFirstRay = x >> DIVIDE_BY_2;
+  viewportStopRay = (x + width) >> DIVIDE_BY_2;
+  viewportCentreRay = (x + (width >> DIVIDE_BY_2)) >> DIVIDE_BY_2;
+  viewportY = y;
+  viewportStopY = y + height;
+  horizonY = y + (height >> DIVIDE_BY_2);
+  
+  // The rows outside of the viewport are seen as already covered by the see-through blocks, so they do not keep the rays going
+  memset(viewportCoverage, 0xFF, sizeof(viewportCoverage));
+  for (uint8_t row=viewportY; row<viewportStopY; row++) viewportCoverage[row >> DIVIDE_BY_8] &= ~(1 << (row & 7));
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Run one simulation tick : player rotation and move, and entities move when an entities store is attached.
+// The player rotation and move are not reset : update() and step() reset them after the simulation.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+void ARCE::simulate() {
+  
   int16_t playerRotForSin = 0;             // Player rotation angle for calculate player rotation angle sinus. Sinus value can be calculated from a cosinus value : Sin(A) = Cos(A - 90).                                       
   int8_t playerRotCosBy16 = 0;             // Player rotation angle cosinus. This value is multiplied by 16 in order to use integers.
   int8_t playerRotSinBy16 = 0;             // Player rotation angle sinus. This value is multiplied by 16 in order to use integers.
@@ -102,10 +607,8 @@ void ARCE::update() {
   uint16_t newPlayerY = 0;                                                 // New player Y position (word coordinates).
   uint8_t newPlayerXOnMap = 0;                                             // New player X position on the world map (word map coordinates).
   uint8_t newPlayerYOnMap = 0;                                             // New player Y position on the world map (word map coordinates).
-  uint8_t blockSizeOnScreen = BLOCK_SIZE / WORLD_TO_SCREEN_SCALING_FACTOR; // Block size on the screen (screen coordinates). This value is usefull for 2D view.
-  uint8_t playerXOnScreen = player.x / WORLD_TO_SCREEN_SCALING_FACTOR;     // New player X position on the screen (screen coordinates). This value is usefull for 2D view.
-  uint8_t playerYOnScreen = player.y / WORLD_TO_SCREEN_SCALING_FACTOR;     // New player Y position on the screen (screen coordinates). This value is usefull for 2D view.
-  int16_t rayAngle;                                                        // Ray Angle used for cast a ray.
+  
+  ARCE_PROFILE_START(simulate);
 
   // Update player rotation. Rotation angle should remain between 0 and 360 degrees.
   player.rot += player.rotDir * player.rotStep;
@@ -117,6 +620,7 @@ void ARCE::update() {
   playerRotSinBy16 = pgm_read_byte(cosBy16 + playerRotForSin);
 
   // Prepare player collision check
+  ARCE_PROFILE_COUNT(mapReads, 1);
   playerMoveForColCheck = player.moveDir * (player.moveStep + PLAYER_COLLISION_MIN_DIST);
   nextPlayerXForColCheck = player.x + playerRotCosBy16 * playerMoveForColCheck;
   nextPlayerYForColCheck = player.y + playerRotSinBy16 * playerMoveForColCheck;
@@ -126,7 +630,7 @@ void ARCE::update() {
   // If the next player position is inside the world and outside a obstacle
   if (nextPlayerXForColCheck >= 0 && nextPlayerXForColCheck < worldWidth && 
       nextPlayerYForColCheck >= 0 && nextPlayerYForColCheck < worldHeight && 
-      pgm_read_byte(worldMap + nextPlayerYOnMapForColCheck * worldMapWidth + nextPlayerXOnMapForColCheck) == 0) {
+      ARCE_READ_BYTE(worldMap + nextPlayerYOnMapForColCheck * worldMapWidth + nextPlayerXOnMapForColCheck) == 0) {
         
       // The next player position is OK and updated
       playerMove = player.moveDir * player.moveStep;
@@ -137,24 +641,37 @@ void ARCE::update() {
       player.x = newPlayerX;
       player.y = newPlayerY;
   }
-    
+  
+  // Move the entities
+  if (entities) updateEntities(entities);
+  
+  ARCE_PROFILE_STOP(simulate);
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Render the current view into the screen buffer. The screen buffer must be cleared before.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+void ARCE::render() {
+  
+  uint32_t renderStartMicros = micros(); // Time of the render start (microseconds).
+  int16_t rayAngle;                      // Ray Angle used for cast a ray.
+  uint8_t firstRay = 0;                  // First ray cast.
+  uint8_t stopRay = RAY_COUNT;           // Ray after the last ray cast.
+  bool planeRays = false;                // Tells if the rays go through the camera plane (RAY_MODE_CAMERA_PLANE in the 3D views).
+  int16_t forwardXBy128 = 0;             // X direction of the player orientation, multiplied by 128.
+  int16_t forwardYBy128 = 0;             // Y direction of the player orientation, multiplied by 128.
+  int16_t planeOffset = 0;               // Distance between the centre of the projection and the centre of the first slice (screen coordinates).
+  int32_t rayDirXBy32768 = 0;            // X direction of the current camera plane ray, multiplied by 32768 (128 along the player orientation, 8 fractional bits).
+  int32_t rayDirYBy32768 = 0;            // Y direction of the current camera plane ray, multiplied by 32768.
+  int32_t rayDirStepXBy32768 = 0;        // X direction step between two camera plane rays, multiplied by 32768.
+  int32_t rayDirStepYBy32768 = 0;        // Y direction step between two camera plane rays, multiplied by 32768.
+
   // If the view is a 2D view, draw the world map with the player on the screen
   if (view == VIEW_2D_ONERAY || view == VIEW_2D) {
     
-    // Draw the world map    
-    for (uint8_t blockY=0; blockY<worldMapHeight; blockY++) {
-      
-      for (uint8_t blockX=0; blockX<worldMapWidth; blockX++) {
-       
-        if (pgm_read_byte(worldMap + blockY * worldMapWidth + blockX) > 0) {
-  
-  	  display.drawRect(blockX * blockSizeOnScreen, blockY * blockSizeOnScreen, blockSizeOnScreen, blockSizeOnScreen, 1);
-        }
-      }
-    }
-    
-    // Draw the player 
-    display.drawRect(playerXOnScreen - 1, playerYOnScreen - 1, 2, 2, 1);
+    ARCE_PROFILE_START(raster);
+    drawMap();
+    ARCE_PROFILE_STOP(raster);
   }
   
   // If the view is the VIEW_2D_ONERAY view
@@ -167,34 +684,469 @@ void ARCE::update() {
   // If the view is the VIEW_2D view
   else {
   
-    // Cast player field of view rays
-    rayAngle = player.rot - 32;
-    for (uint8_t rayNumber=0; rayNumber<64; rayNumber++) {
+    // Choose the resolution : 64 rays with 2 pixels wide slices, or 32 rays with 4 pixels wide slices
+    if (resolution == RESOLUTION_LOW || (resolution == RESOLUTION_ADAPTIVE && adaptiveLowResolution)) rayStep = 2;
+    else rayStep = 1;
+    sliceWidth = rayStep << MULTIPLY_BY_2;
+    
+    // Cast player field of view rays : the whole field of view in the VIEW_2D view, the rays of the viewport in the 3D views
+    if (view == VIEW_2D) {
+      
+      rayAngle = player.rot - HALF_FOV;
+    }
+    else {
+      
+      firstRay = viewportFirstRay;
+      stopRay = viewportStopRay;
+      rayAngle = player.rot + viewportFirstRay - viewportCentreRay;
+    }
+    // Camera plane rays : a ray goes from the player through the centre of its slice on the projection plane, so the ray direction is the player 
+    // orientation plus an offset along the camera plane, and this offset grows by the same step from a ray to the next one. Only the player 
+    // orientation needs a cosinus.
+    planeRays = view != VIEW_2D && rayMode == RAY_MODE_CAMERA_PLANE;
+    if (planeRays) {
+      
+      forwardXBy128 = getCosBy128(player.rot);
+      forwardYBy128 = getCosBy128(player.rot - 90); // Sin(A) = Cos(A - 90)
+      planeOffset = ((firstRay - viewportCentreRay) << MULTIPLY_BY_2) + rayStep;
+      rayDirXBy32768 = ((int32_t)forwardXBy128 << 8) - (((int32_t)forwardYBy128 * planeOffset) << 8) / PROJECTION_DISTANCE;
+      rayDirYBy32768 = ((int32_t)forwardYBy128 << 8) + (((int32_t)forwardXBy128 * planeOffset) << 8) / PROJECTION_DISTANCE;
+      rayDirStepXBy32768 = -(((int32_t)forwardYBy128 * sliceWidth) << 8) / PROJECTION_DISTANCE;
+      rayDirStepYBy32768 = (((int32_t)forwardXBy128 * sliceWidth) << 8) / PROJECTION_DISTANCE;
+    }
+    
+    for (uint8_t rayNumber=firstRay; rayNumber<stopRay; rayNumber+=rayStep) {
+      
+      if (planeRays) {
+        
+        castRay(rayNumber, 0, (rayDirXBy32768 + 128) >> 8, (rayDirYBy32768 + 128) >> 8);
+        rayDirXBy32768 += rayDirStepXBy32768;
+        rayDirYBy32768 += rayDirStepYBy32768;
+      }
+      else {
+        
+        castRay(rayNumber, rayAngle);
+        rayAngle += rayStep;
+      }
+    }
+    
+    // Draw the player over the field of view of the VIEW_2D view
+    if (view == VIEW_2D) drawPlayer(false);
+    
+    // If the view is a 3D view, render the floor and the ceiling around the slices
+    if ((view == VIEW_3D_SOLID || view == VIEW_3D_TEXTURED) && (floorMode != SURFACE_NONE || ceilingMode != SURFACE_NONE)) {
       
-      castRay(rayNumber, rayAngle);
-      rayAngle++;
+      castFloorAndCeiling();
     }
+    
+    // Draw the minimap over the 3D view
+    if ((view == VIEW_3D_SOLID || view == VIEW_3D_TEXTURED) && minimap) drawMinimap();
   }
   
-  // Reset player move and rotation for next frame
-  player.moveDir = PLAYER_MOVE_NONE;
-  player.rotDir = PLAYER_ROTATE_NONE;
+  // Measure the render time and adapt the resolution
+  renderMicros = micros() - renderStartMicros;
+  if (replay) replay->checkFrame(buffer, renderMicros);
+  if (resolution == RESOLUTION_ADAPTIVE) adaptResolution();
 }
 
 // ------------------------------------------------------------------------------------------------------------------------------------------------------
-// Cast a ray with a given number and a given angle.
+// Draw the visible part of the world map and the player for the 2D views. The viewport is centred on the player and stays inside the map, so only the 
+// blocks seen on the screen are read. Each block outline is written column by column into the screen buffer, instead of a drawRect() call per block.
 // ------------------------------------------------------------------------------------------------------------------------------------------------------
-void ARCE::castRay(uint8_t rayNumber, int16_t rayAngle) {
+void ARCE::drawMap() {
   
-  uint8_t vccCosBy128 = 0;                // Ray angle cosinus multiplied by 128 for vertical collision check (vcc).
-  uint16_t vccSinBy128 = 0;               // Ray angle sinus multiplied by 128 for vertical collision check.
-  uint16_t vccTanByBlockSize = 0;         // Ray angle tangente multiplied by BLOCK_SIZE for vertical collision check.
-  int16_t vccX = 0;                       // X position of the vertical collision check (world coordinates).
-  int16_t vccY = 0;                       // Y position of the vertical collision check (world coordinates).
-  int16_t vccStepX = 0;                   // Step to make along the X axis during the vertical collision check (world coordinates).
-  int16_t vccStepY = 0;                   // Step to make along the Y axis during the vertical collision check (world coordinates).
-  uint8_t hccCosBy128 = 0;                // Ray angle cosinus multiplied by 128 for horizontal collision check (hcc).
-  uint16_t hccSinBy128 = 0;               // Ray angle sinus multiplied by 128 for horizontal collision check.
+  uint8_t worldToMapShift = MULTIPLY_BY_BLOCK_SIZE - mapZoom; // Bit shift used to convert world coordinates to map coordinates on the screen.
+  uint8_t blockSizeOnScreen = 1 << mapZoom;                   // Block size on the screen (screen coordinates).
+  int16_t mapWidthOnScreen = worldMapWidth << mapZoom;        // World map width on the screen (screen coordinates).
+  int16_t mapHeightOnScreen = worldMapHeight << mapZoom;      // World map height on the screen (screen coordinates).
+  uint16_t blockEdgePixels = (1 << blockSizeOnScreen) - 1;    // Pixels of the left and right columns of a block outline (1 bit per row).
+  uint16_t blockInnerPixels = 1 | (1 << (blockSizeOnScreen - 1)); // Pixels of the other columns of a block outline : top row and bottom row.
+  uint8_t firstBlockX = 0;                                    // X position of the first visible block (world map coordinates).
+  uint8_t firstBlockY = 0;                                    // Y position of the first visible block (world map coordinates).
+  uint8_t lastBlockX = 0;                                     // X position of the last visible block (world map coordinates).
+  uint8_t lastBlockY = 0;                                     // Y position of the last visible block (world map coordinates).
+  int16_t blockScreenX = 0;                                   // X position of the current block on the screen (screen coordinates).
+  int16_t blockScreenY = 0;                                   // Y position of the current block on the screen, moved one page down so it is never negative.
+  int8_t blockPage = 0;                                       // Screen buffer page of the top of the current block (-1 when the block starts above the screen).
+  uint8_t blockShift = 0;                                     // Position of the top of the current block inside its page.
+  bool blockSolid = false;                                    // Tells if the current block is solid.
+  int16_t columnX = 0;                                        // X position of the current block column on the screen (screen coordinates).
+  uint16_t columnPixels = 0;                                  // Pixels of the current block column, over two pages.
+  
+  // Centre the viewport on the player and keep it inside the map
+  mapScrollX = (player.x >> worldToMapShift) - HALF_SCREEN_WIDTH;
+  if (mapScrollX > mapWidthOnScreen - SCREEN_WIDTH) mapScrollX = mapWidthOnScreen - SCREEN_WIDTH;
+  if (mapScrollX < 0) mapScrollX = 0;
+  mapScrollY = (player.y >> worldToMapShift) - HALF_SCREEN_HEIGHT;
+  if (mapScrollY > mapHeightOnScreen - SCREEN_HEIGHT) mapScrollY = mapHeightOnScreen - SCREEN_HEIGHT;
+  if (mapScrollY < 0) mapScrollY = 0;
+  
+  // Find the visible blocks
+  firstBlockX = mapScrollX >> mapZoom;
+  firstBlockY = mapScrollY >> mapZoom;
+  if (mapWidthOnScreen > mapScrollX + SCREEN_WIDTH) lastBlockX = (mapScrollX + SCREEN_WIDTH - 1) >> mapZoom; else lastBlockX = worldMapWidth - 1;
+  if (mapHeightOnScreen > mapScrollY + SCREEN_HEIGHT) lastBlockY = (mapScrollY + SCREEN_HEIGHT - 1) >> mapZoom; else lastBlockY = worldMapHeight - 1;
+  
+  // Draw the visible blocks
+  for (uint8_t blockY=firstBlockY; blockY<=lastBlockY; blockY++) {
+    
+    blockScreenY = (blockY << mapZoom) - mapScrollY + 8;
+    blockPage = (blockScreenY >> DIVIDE_BY_8) - 1;
+    blockShift = blockScreenY & 7;
+    
+    for (uint8_t blockX=firstBlockX; blockX<=lastBlockX; blockX++) {
+      
+      // Read the block from the map cache, or from the world map when it does not fit in the map cache
+      if (mapCacheRowSize) blockSolid = mapCache[blockY * mapCacheRowSize + (blockX >> DIVIDE_BY_8)] & (1 << (blockX & 7));
+      else blockSolid = ARCE_READ_BYTE(worldMap + blockY * worldMapWidth + blockX) > 0;
+      if (!blockSolid) continue;
+      
+      // Write the block outline, column by column, over one or two pages
+      blockScreenX = (blockX << mapZoom) - mapScrollX;
+      if (blockPage >= 0) dirtyPages |= 1 << blockPage;
+      if (blockPage < (SCREEN_HEIGHT >> DIVIDE_BY_8) - 1) dirtyPages |= 2 << blockPage;
+      for (uint8_t column=0; column<blockSizeOnScreen; column++) {
+        
+        columnX = blockScreenX + column;
+        if (columnX < 0 || columnX >= SCREEN_WIDTH) continue;
+        
+        if (column == 0 || column == blockSizeOnScreen - 1) columnPixels = blockEdgePixels << blockShift;
+        else columnPixels = blockInnerPixels << blockShift;
+        if (blockPage >= 0) buffer[(blockPage << MULTIPLY_BY_128) + columnX] |= columnPixels;
+        if (blockPage < (SCREEN_HEIGHT >> DIVIDE_BY_8) - 1) buffer[((blockPage + 1) << MULTIPLY_BY_128) + columnX] |= columnPixels >> 8;
+      }
+    }
+  }
+  
+  // Draw the player 
+  drawPlayer(true);
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Draw the player as a 2 x 2 pixels square on the 2D views : lit over the map, cleared over the field of view of the VIEW_2D view.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+void ARCE::drawPlayer(bool color) {
+  
+  uint8_t worldToMapShift = MULTIPLY_BY_BLOCK_SIZE - mapZoom;          // Bit shift used to convert world coordinates to map coordinates on the screen.
+  int16_t playerX = (player.x >> worldToMapShift) - mapScrollX - 1;   // X position of the top left pixel of the player (screen coordinates).
+  int16_t playerY = (player.y >> worldToMapShift) - mapScrollY - 1;   // Y position of the top left pixel of the player (screen coordinates).
+  
+  drawPixel(playerX, playerY, color);
+  drawPixel(playerX + 1, playerY, color);
+  drawPixel(playerX, playerY + 1, color);
+  drawPixel(playerX + 1, playerY + 1, color);
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Write a pixel into the render target. Pixels outside of the screen are ignored.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+void ARCE::drawPixel(int16_t x, int16_t y, bool color) {
+  
+  if (x < 0 || x >= SCREEN_WIDTH || y < 0 || y >= SCREEN_HEIGHT) return;
+  
+  dirtyPages |= 1 << (y >> DIVIDE_BY_8);
+  if (color) buffer[((y >> DIVIDE_BY_8) << MULTIPLY_BY_128) + x] |= 1 << (y & 7);
+  else buffer[((y >> DIVIDE_BY_8) << MULTIPLY_BY_128) + x] &= ~(1 << (y & 7));
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Draw a line into the render target with the Bresenham algorithm, one pixel for each step along the major axis. Pixels outside of the screen are 
+// ignored.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+void ARCE::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1) {
+  
+  bool steep = abs(y1 - y0) > abs(x1 - x0); // Tells if the line is closer to the Y axis : X and Y are then swapped, so the major axis is X.
+  int16_t swapValue = 0;                    // Value used to swap two coordinates.
+  int16_t deltaX = 0;                       // Length of the line along the major axis.
+  int16_t deltaY = 0;                       // Absolute length of the line along the minor axis.
+  int16_t error = 0;                        // Distance to the next step along the minor axis (multiplied by deltaX).
+  int8_t stepY = 0;                         // Step along the minor axis.
+  
+  if (steep) { swapValue = x0; x0 = y0; y0 = swapValue; swapValue = x1; x1 = y1; y1 = swapValue; }
+  if (x0 > x1) { swapValue = x0; x0 = x1; x1 = swapValue; swapValue = y0; y0 = y1; y1 = swapValue; }
+  
+  deltaX = x1 - x0;
+  deltaY = abs(y1 - y0);
+  error = deltaX >> DIVIDE_BY_2;
+  stepY = y0 < y1 ? 1 : -1;
+  
+  for (; x0<=x1; x0++) {
+    
+    if (steep) drawPixel(y0, x0, true); else drawPixel(x0, y0, true);
+    error -= deltaY;
+    if (error < 0) {
+      
+      y0 += stepY;
+      error += deltaX;
+    }
+  }
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Draw the minimap, the player and its heading over a 3D view. The downsampled map is built by loadWorldMap() in the screen buffer layout, so it is 
+// copied byte by byte. castRay() and castFloorAndCeiling() do not render the 3D view under the minimap.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+void ARCE::drawMinimap() {
+  
+  uint8_t worldToMinimapShift = MULTIPLY_BY_BLOCK_SIZE + minimapShift; // Bit shift used to convert world coordinates to minimap coordinates.
+  int16_t pointX = 0;                                                  // X position of the current point in the minimap (minimap coordinates).
+  int16_t pointY = 0;                                                  // Y position of the current point in the minimap (minimap coordinates).
+  
+  ARCE_PROFILE_START(raster);
+  
+  // Copy the downsampled map
+  for (uint8_t page=0; page<MINIMAP_PAGES; page++) {
+    
+    memcpy(buffer + (page << MULTIPLY_BY_128) + minimapX, minimapBitmap + page * MINIMAP_WIDTH, MINIMAP_WIDTH);
+    dirtyPages |= 1 << page;
+  }
+  
+  // Draw the player (inverted, so it can be seen on the blocks)
+  pointX = player.x >> worldToMinimapShift;
+  pointY = player.y >> worldToMinimapShift;
+  if (pointX < MINIMAP_WIDTH && pointY < MINIMAP_HEIGHT) buffer[((pointY >> DIVIDE_BY_8) << MULTIPLY_BY_128) + minimapX + pointX] ^= 1 << (pointY & 7);
+  
+  // Draw the player heading, 3 minimap pixels in front of the player
+  pointX = (player.x + (((getCosBy128(player.rot) * 3) << minimapShift) >> DIVIDE_BY_2)) >> worldToMinimapShift;
+  pointY = (player.y + (((getCosBy128(player.rot - 90) * 3) << minimapShift) >> DIVIDE_BY_2)) >> worldToMinimapShift; // Sin(A) = Cos(A - 90)
+  if (pointX >= 0 && pointX < MINIMAP_WIDTH && pointY >= 0 && pointY < MINIMAP_HEIGHT) {
+    
+    buffer[((pointY >> DIVIDE_BY_8) << MULTIPLY_BY_128) + minimapX + pointX] |= 1 << (pointY & 7);
+  }
+  
+  ARCE_PROFILE_STOP(raster);
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Send the screen buffer to the display and end the frame. Can be used instead of "display.display()" after render().
+// With the clearAfterDisplay option, the screen buffer is also cleared, so "display.clearDisplay()" is not needed before the next render().
+// The screen buffer sent is the render target (see setRenderTarget()). Host builds write it into ARCE.displayMemory instead of the display.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+void ARCE::displayFrame() {
+  
+  ARCE_PROFILE_START(display);
+  
+  if (dirtyTracking) {
+    
+    displayDirtyPages();
+  }
+#ifdef ARCE_HOST
+  else {
+    
+    // The display window covers the whole screen here (see displayDirtyPages())
+    sendScreenBytes(buffer, SCREEN_BUFFER_SIZE);
+  }
+#else
+  else if (clearAfterDisplay || buffer != display.getBuffer()) {
+    
+    display.LCDDataMode();
+    sendScreenBytes(buffer, SCREEN_BUFFER_SIZE);
+  }
+  else {
+    
+    display.display();
+    ARCE_PROFILE_COUNT(displayBytes, SCREEN_BUFFER_SIZE);
+  }
+#endif
+  
+  ARCE_PROFILE_STOP(display);
+  
+  // The next frame starts with no page drawn
+  lastDirtyPages = dirtyPages;
+  dirtyPages = 0;
+  
+#ifdef ARCE_PROFILE
+  // Keep the statistics of the complete frame and start the next frame
+  frameStats = stats;
+  stats = ARCEStats();
+#endif
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Mark a given screen buffer page as drawn, or all the pages with DIRTY_ALL_PAGES. The engine marks its own drawings : this function is used for the 
+// drawings made with the Arduboy library (text, HUD...) when the dirty tracking is used.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+void ARCE::markDirty(uint8_t page) {
+  
+  if (page == DIRTY_ALL_PAGES) dirtyPages = 0xFF;
+  else dirtyPages |= 1 << page;
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Send only the screen buffer pages drawn in this frame or in the last one to the display. The drawing paths mark the pages they write (see 
+// markDirty()), so no byte of the screen buffer is read to find them. A page drawn in the last frame is sent again : it may have been cleared since, 
+// and it then has to be cleared on the display. Each run of consecutive pages is sent in one display window, with the display controller addressing
+// commands. A full refresh is sent every DIRTY_FULL_REFRESH_FRAMES frames, in case a drawing was not marked.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+void ARCE::displayDirtyPages() {
+  
+  uint8_t sentPages = dirtyPages | lastDirtyPages; // Pages sent to the display, one bit for each page.
+  uint8_t firstPage = 0;                           // First page of the current run of pages to send.
+  
+  if (framesSinceFullRefresh == 0) sentPages = 0xFF;
+  if (++framesSinceFullRefresh == DIRTY_FULL_REFRESH_FRAMES) framesSinceFullRefresh = 0;
+  
+  for (uint8_t page=0; page<(SCREEN_HEIGHT >> DIVIDE_BY_8); page++) {
+    
+    if (!(sentPages & (1 << page))) {
+      
+      // The pages which are not sent have to be cleared too
+      if (clearAfterDisplay) memset(buffer + (page << MULTIPLY_BY_128), 0, SCREEN_WIDTH);
+      continue;
+    }
+    
+    // Send the run of pages when it ends with this page
+    if (page == 0 || !(sentPages & (1 << (page - 1)))) firstPage = page;
+    if (page == (SCREEN_HEIGHT >> DIVIDE_BY_8) - 1 || !(sentPages & (1 << (page + 1)))) {
+      
+      setDisplayWindow(0, SCREEN_WIDTH - 1, firstPage, page);
+      sendScreenBytes(buffer + (firstPage << MULTIPLY_BY_128), (page - firstPage + 1) << MULTIPLY_BY_128);
+    }
+  }
+  
+  // The Arduboy library sends whole frames : restore the whole screen window
+  if (sentPages && sentPages != 0xFF) setDisplayWindow(0, SCREEN_WIDTH - 1, 0, (SCREEN_HEIGHT >> DIVIDE_BY_8) - 1);
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Set the display window (columns and pages) written by the next data bytes, with the display controller addressing commands.
+// The display is left in data mode.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+void ARCE::setDisplayWindow(uint8_t firstColumn, uint8_t lastColumn, uint8_t firstPage, uint8_t lastPage) {
+  
+#ifdef ARCE_HOST
+  // The display controller moves its cursor to the window start
+  displayFirstColumn = displayColumn = firstColumn;
+  displayLastColumn = lastColumn;
+  displayFirstPage = displayPage = firstPage;
+  displayLastPage = lastPage;
+#else
+  display.LCDCommandMode();
+  SPI.transfer(OLED_SET_COLUMN_ADDRESS);
+  SPI.transfer(firstColumn);
+  SPI.transfer(lastColumn);
+  SPI.transfer(OLED_SET_PAGE_ADDRESS);
+  SPI.transfer(firstPage);
+  SPI.transfer(lastPage);
+  display.LCDDataMode();
+#endif
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Send bytes of the screen buffer to the display, which must be in data mode. With the clearAfterDisplay option, each byte is cleared while it is 
+// shifted out : the SPI transfer waits are used to clear the screen buffer.
+// The clear never overtakes the transfer : a byte is only cleared once SPDR holds its copy (the SPI shift register is loaded by the SPDR write), and 
+// the next byte is not read before SPIF tells that the previous byte is shifted out. So the cleared byte is always the byte being sent, and the bytes
+// not sent yet are untouched. The render of the next frame starts after this function returns : no drawing can reach a byte before it is sent.
+// Host builds write the display memory instead of SPDR, in the same order : tools/ARCECheck checks that the display memory gets each frame intact.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+void ARCE::sendScreenBytes(uint8_t *bytes, uint16_t count) {
+  
+  ARCE_PROFILE_COUNT(displayBytes, count);
+  
+  for (uint16_t bytePos=0; bytePos<count; bytePos++) {
+    
+#ifdef ARCE_HOST
+    writeDisplayByte(bytes[bytePos]);          // The byte is written into the display memory...
+    if (clearAfterDisplay) bytes[bytePos] = 0; // ...before its buffer copy is cleared
+#else
+    SPDR = bytes[bytePos];                     // The byte is copied into the SPI shift register...
+    if (clearAfterDisplay) bytes[bytePos] = 0; // ...so its buffer copy can be cleared while it is shifted out
+    while (!(SPSR & _BV(SPIF)));               // The next byte waits for the end of this transfer
+#endif
+  }
+}
+
+#ifdef ARCE_HOST
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Write a byte at the display cursor of the display memory, and move the cursor in the display window, column by column then page by page, as the 
+// display controller does in its horizontal addressing mode (host builds).
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+void ARCE::writeDisplayByte(uint8_t value) {
+  
+  displayMemory[(displayPage << MULTIPLY_BY_128) + displayColumn] = value;
+  
+  if (displayColumn++ == displayLastColumn) {
+    
+    displayColumn = displayFirstColumn;
+    if (displayPage++ == displayLastPage) displayPage = displayFirstPage;
+  }
+}
+#endif
+
+#if defined(ARCE_PROFILE) && !defined(ARCE_HOST)
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Print the statistics of the last complete frame over Serial (one line for each frame). "Serial.begin()" must be called before.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+void ARCE::printStats() {
+  
+  Serial.print(F("rays "));
+  Serial.print(frameStats.rays);
+  Serial.print(F(" vcc "));
+  Serial.print(frameStats.vccSteps);
+  Serial.print(F(" hcc "));
+  Serial.print(frameStats.hccSteps);
+  Serial.print(F(" map "));
+  Serial.print(frameStats.mapReads);
+  Serial.print(F(" texels "));
+  Serial.print(frameStats.texelFetches);
+  Serial.print(F(" pixels "));
+  Serial.print(frameStats.pixelsWritten);
+  Serial.print(F(" sent "));
+  Serial.print(frameStats.displayBytes);
+  Serial.print(F(" | simulate "));
+  Serial.print(frameStats.simulateMicros);
+  Serial.print(F(" trace "));
+  Serial.print(frameStats.traceMicros);
+  Serial.print(F(" raster "));
+  Serial.print(frameStats.rasterMicros);
+  Serial.print(F(" display "));
+  Serial.println(frameStats.displayMicros);
+}
+#endif
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Adapt the resolution of the 3D views to the measured render time. The resolution only changes after RESOLUTION_SWITCH_FRAMES frames in a row ask 
+// for it, and the thresholds are far apart (hysteresis), so the resolution does not flicker between two frames.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+void ARCE::adaptResolution() {
+  
+  bool switchWanted = false; // Tells if the last render time asks for the other resolution.
+  
+  // Low resolution casts half the rays : going back to the high resolution is only done when the frame should still be well inside the target
+  if (adaptiveLowResolution) switchWanted = renderMicros < (uint32_t)((targetRenderMicros >> 1) - (targetRenderMicros >> 3));
+  else switchWanted = renderMicros > targetRenderMicros;
+  
+  if (!switchWanted) {
+    
+    resolutionSwitchFrames = 0;
+    return;
+  }
+  
+  resolutionSwitchFrames++;
+  if (resolutionSwitchFrames == RESOLUTION_SWITCH_FRAMES) {
+    
+    adaptiveLowResolution = !adaptiveLowResolution;
+    resolutionSwitchFrames = 0;
+  }
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Cast a ray with a given number and a given angle. When a direction is given (rayDirXBy128, rayDirYBy128 not both 0), the ray is a camera plane ray 
+// instead : the direction is 128 long along the player orientation, the angle is not used, and the ray length is the perpendicular distance to the 
+// block hit, so it needs no fishbowl correction.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+void ARCE::castRay(uint8_t rayNumber, int16_t rayAngle, int16_t rayDirXBy128, int16_t rayDirYBy128) {
+  
+  uint8_t vccCosBy128 = 0;                // Ray angle cosinus multiplied by 128 for vertical collision check (vcc).
+  uint16_t vccSinBy128 = 0;               // Ray angle sinus multiplied by 128 for vertical collision check.
+  uint16_t vccTanByBlockSize = 0;         // Ray angle tangente multiplied by BLOCK_SIZE for vertical collision check.
+  int16_t vccX = 0;                       // X position of the vertical collision check (world coordinates).
+  int16_t vccY = 0;                       // Y position of the vertical collision check (world coordinates).
+  int16_t vccStepX = 0;                   // Step to make along the X axis during the vertical collision check (world coordinates).
+  int16_t vccStepY = 0;                   // Step to make along the Y axis during the vertical collision check (world coordinates).
+  uint8_t hccCosBy128 = 0;                // Ray angle cosinus multiplied by 128 for horizontal collision check (hcc).
+  uint16_t hccSinBy128 = 0;               // Ray angle sinus multiplied by 128 for horizontal collision check.
   uint16_t hccTanByBlockSize = 0;         // Ray angle tangente multiplied by BLOCK_SIZE for horizontal collision check.
   int16_t hccX = 0;                       // X position of the horizontal collision check (world coordinates).
   int16_t hccY = 0;                       // Y position of the horizontal collision check (world coordinates).
@@ -210,345 +1162,1538 @@ void ARCE::castRay(uint8_t rayNumber, int16_t rayAngle) {
   uint8_t blockType = 0;                  // Type of the block chosen between vertical collision check hit block and horizontal collision check hit block.
   uint16_t blockHitX = 0;                 // X position of the ray in the block hit (world coordinates).
   uint16_t blockHitY = 0;                 // Y position of the ray in the block hit (world coordinates).
-  uint8_t textureSliceX = 0;              // X position of the ray in the block hit texture. That's the X position of texels in the texture used by the projected slice (texture coordinates).
+  uint8_t blockHitOffset = 0;             // Position of the ray along the face of the block hit, from 0 to BLOCK_SIZE - 1 in the texture orientation (world coordinates).
   uint8_t vccTextureOrient = 0;           // Tells how to render the texture of the block hit by the vertical collision check ray : from left to right or right to left (TEXTURE_ORIENT_LEFT_TO_RIGHT or TEXTURE_ORIENT_RIGHT_TO_LEFT). 
   uint8_t hccTextureOrient = 0;           // Tells how to render the texture of the block hit by the horizontal collision check ray : from left to right or right to left (TEXTURE_ORIENT_LEFT_TO_RIGHT or TEXTURE_ORIENT_RIGHT_TO_LEFT).
+  int16_t coverageTopY = SCREEN_HEIGHT;   // Y position of the highest row covered by the rendered blocks (screen coordinates). SCREEN_HEIGHT until a block is rendered.
+  bool moreHits = true;                   // Tells if the blocks behind the rendered blocks can still be seen.
+  bool nearestHit = true;                 // Tells if the current block is the nearest block hit by the ray.
+  bool transparentHit = false;            // Tells if the current block is a see-through block : a block with a masked texture, rendered in VIEW_3D_TEXTURED view.
+  uint8_t lightFace = 0;                  // Face of the block hit by the ray (LIGHT_FACE_NORTH, LIGHT_FACE_EAST, LIGHT_FACE_SOUTH or LIGHT_FACE_WEST).
+  uint8_t lightLevel = 0;                 // Baked light level of the face hit by the ray (0 = lit).
+  uint8_t transparentHits = 0;            // Number of see-through blocks rendered by the ray.
+  int16_t hitXOnMap = 0;                  // X position of the ray hit on the screen, with MAP_SUBPIXEL_BITS fractional bits (VIEW_2D view).
+  int16_t hitYOnMap = 0;                  // Y position of the ray hit on the screen, with MAP_SUBPIXEL_BITS fractional bits (VIEW_2D view).
+  uint16_t vccStepsLeft = 0xFFFF;         // Number of vertical grid lines the vertical collision check can still cross before the view distance.
+  uint16_t hccStepsLeft = 0xFFFF;         // Number of horizontal grid lines the horizontal collision check can still cross before the view distance.
+  int32_t tempLong;                       // Variable used for 24 or 32 bits operations (sometimes only...). 
+  bool planeRay = rayDirXBy128 || rayDirYBy128; // Tells if the ray is a camera plane ray.
+  bool enclosed = enclosedWorldMap && (uint16_t)(player.x - BLOCK_SIZE) < worldWidth - (BLOCK_SIZE << MULTIPLY_BY_2) && 
+                  (uint16_t)(player.y - BLOCK_SIZE) < worldHeight - (BLOCK_SIZE << MULTIPLY_BY_2); // Tells if the ray starts inside an enclosed world map : the collision checks then only test one world border.
+  
+  ARCE_PROFILE_COUNT(rays, 1);
+  ARCE_PROFILE_START(trace);
+  
+  // No slice is rendered yet in the ray column
+  coverageMasking = false;
+  sliceTopY[rayNumber] = SCREEN_HEIGHT;
+  sliceBottomY[rayNumber] = horizonY - 1;
+  
+  // Camera plane ray : the collision checks are set up from the signs and the ratio of the direction components. The X and Y components play the
+  // parts of the angle cosinus and sinus : the ray lengths found are then the distances along the player orientation.
+  if (planeRay) {
+    
+    // Vertical collision check setup
+    vccCosBy128 = abs(rayDirXBy128);
+    vccSinBy128 = abs(rayDirYBy128);
+    if (vccCosBy128) vccTanByBlockSize = (vccSinBy128 << MULTIPLY_BY_BLOCK_SIZE) / vccCosBy128;
+    if (rayDirXBy128 > 0) {
+      
+      vccStepX = BLOCK_SIZE;
+      vccX = player.x + BLOCK_SIZE - (player.x & (BLOCK_SIZE - 1)); // Equals to "vccX = player.x + BLOCK_SIZE - (player.x % BLOCK_SIZE);"
+      vccTextureOrient = TEXTURE_ORIENT_LEFT_TO_RIGHT;
+    }
+    else {
+      
+      vccStepX = -BLOCK_SIZE;
+      vccX = player.x - (player.x & (BLOCK_SIZE - 1)) - 1; // Equals to "vccX = player.x - (player.x % BLOCK_SIZE) - 1;"
+      vccTextureOrient = TEXTURE_ORIENT_RIGHT_TO_LEFT;
+    }
+    tempLong = abs(vccX - player.x);
+    tempLong = tempLong * vccTanByBlockSize;
+    if (rayDirYBy128 > 0) vccStepY = vccTanByBlockSize; else vccStepY = -vccTanByBlockSize;
+    if (rayDirYBy128 > 0) vccY = player.y + (tempLong >> DIVIDE_BY_BLOCK_SIZE); else vccY = player.y - (tempLong >> DIVIDE_BY_BLOCK_SIZE);
+    
+    // Horizontal collision check setup
+    hccCosBy128 = abs(rayDirYBy128);
+    hccSinBy128 = abs(rayDirXBy128);
+    if (hccCosBy128) hccTanByBlockSize = (hccSinBy128 << MULTIPLY_BY_BLOCK_SIZE) / hccCosBy128;
+    if (rayDirYBy128 > 0) {
+      
+      hccStepY = BLOCK_SIZE;
+      hccY = player.y + BLOCK_SIZE - (player.y & (BLOCK_SIZE - 1)); // Equals to "hccY = player.y + BLOCK_SIZE - (player.y % BLOCK_SIZE);"
+      hccTextureOrient = TEXTURE_ORIENT_RIGHT_TO_LEFT;
+    }
+    else {
+      
+      hccStepY = -BLOCK_SIZE;
+      hccY = player.y - (player.y & (BLOCK_SIZE - 1)) - 1; // Equals to "hccY = player.y - (player.y % BLOCK_SIZE) - 1;"
+      hccTextureOrient = TEXTURE_ORIENT_LEFT_TO_RIGHT;
+    }
+    tempLong = abs(hccY - player.y);
+    tempLong = tempLong * hccTanByBlockSize;
+    if (rayDirXBy128 > 0) hccStepX = hccTanByBlockSize; else hccStepX = -hccTanByBlockSize;
+    if (rayDirXBy128 > 0) hccX = player.x + (tempLong >> DIVIDE_BY_BLOCK_SIZE); else hccX = player.x - (tempLong >> DIVIDE_BY_BLOCK_SIZE);
+    
+    // A collision check along a null component would never cross a grid line : it is disabled by starting it outside of the world
+    if (!rayDirXBy128) vccY = -1;
+    if (!rayDirYBy128) hccX = -1;
+  }
+  
+  // Angle ray
+  else {
+    
+    // Ray angle should remain between 0 and 360 degrees
+    rayAngle %= 360;
+    if (rayAngle < 0) rayAngle += 360;
+  
+    // If the ray is in the first quadrant (bottom right on the cartesian coordinate system)
+    if (rayAngle >= 0 && rayAngle <= 90) {
+    
+      // Setup vertical collision check
+      vccCosBy128 = pgm_read_byte(cosBy128 + rayAngle);
+      vccSinBy128 = pgm_read_byte(cosBy128 + (90 - rayAngle)); 
+      if (rayAngle == 90) vccTanByBlockSize = 0; else vccTanByBlockSize = (vccSinBy128 << MULTIPLY_BY_BLOCK_SIZE) / vccCosBy128; // tan = sin/cos with avoiding a divide by zero
+      vccStepX = BLOCK_SIZE; 	
+      vccStepY = vccTanByBlockSize;
+      vccX = player.x + BLOCK_SIZE - (player.x & (BLOCK_SIZE - 1)); // Equals to "vccX = player.x + BLOCK_SIZE - (player.x % BLOCK_SIZE);"
+      tempLong = vccX - player.x; 
+      tempLong = tempLong * vccTanByBlockSize;
+      vccY = player.y + (tempLong >> DIVIDE_BY_BLOCK_SIZE);
+      vccTextureOrient = TEXTURE_ORIENT_LEFT_TO_RIGHT;
+    
+      // Setup horizontal collision check
+      hccCosBy128 = pgm_read_byte(cosBy128 + (90 - rayAngle));
+      hccSinBy128 = pgm_read_byte(cosBy128 + rayAngle);
+      if (rayAngle == 0) hccTanByBlockSize = 0; else hccTanByBlockSize = (hccSinBy128 << MULTIPLY_BY_BLOCK_SIZE) / hccCosBy128; // tan = sin/cos with avoiding a divide by zero
+      hccStepY = BLOCK_SIZE;	
+      hccStepX = hccTanByBlockSize; 
+      hccY = player.y + BLOCK_SIZE - (player.y & (BLOCK_SIZE - 1)); // Equals to "hccY = player.y + BLOCK_SIZE - (player.y % BLOCK_SIZE);"
+      tempLong = hccY - player.y;
+      tempLong = tempLong * hccTanByBlockSize;
+      hccX = player.x + (tempLong >> DIVIDE_BY_BLOCK_SIZE);
+      hccTextureOrient = TEXTURE_ORIENT_RIGHT_TO_LEFT;
+    }
+  
+    // If the ray is in the second quadrant (bottom left on the cartesian coordinate system)
+    else if (rayAngle > 90 && rayAngle <= 180) {
+    
+      // Vertical collision check setup
+      vccCosBy128 = pgm_read_byte(cosBy128 + (180 - rayAngle));
+      vccSinBy128 = pgm_read_byte(cosBy128 + (rayAngle - 90));
+      if (rayAngle == 90) vccTanByBlockSize = 0; else vccTanByBlockSize = (vccSinBy128 << MULTIPLY_BY_BLOCK_SIZE) / vccCosBy128; // tan = sin/cos with avoiding a divide by zero
+      vccStepX = -BLOCK_SIZE; 	
+      vccStepY = vccTanByBlockSize;
+      vccX = player.x - (player.x & (BLOCK_SIZE - 1)) - 1; // Equals to "vccX = player.x - (player.x % BLOCK_SIZE) - 1;"
+      tempLong = player.x - vccX;
+      tempLong = tempLong * vccTanByBlockSize;
+      vccY = player.y + (tempLong >> DIVIDE_BY_BLOCK_SIZE);
+      vccTextureOrient = TEXTURE_ORIENT_RIGHT_TO_LEFT;
+    
+      // Horizontal collision check setup
+      hccCosBy128 = pgm_read_byte(cosBy128 + (rayAngle - 90));
+      hccSinBy128 = pgm_read_byte(cosBy128 + (180 - rayAngle));
+      if (rayAngle == 180) hccTanByBlockSize = 0; else hccTanByBlockSize = (hccSinBy128 << MULTIPLY_BY_BLOCK_SIZE) / hccCosBy128; // tan = sin/cos with avoiding a divide by zero
+      hccStepY = BLOCK_SIZE;	
+      hccStepX = -hccTanByBlockSize; 
+      hccY = player.y + BLOCK_SIZE - (player.y & (BLOCK_SIZE - 1)); // Equals to "hccY = player.y + BLOCK_SIZE - (player.y % BLOCK_SIZE);"
+      tempLong = hccY - player.y;
+      tempLong = tempLong * hccTanByBlockSize;
+      hccX = player.x - (tempLong >> DIVIDE_BY_BLOCK_SIZE);
+      hccTextureOrient = TEXTURE_ORIENT_RIGHT_TO_LEFT; 
+    }
+  
+    // If the ray is in the third quadrant (top left on the cartesian coordinate system)
+    else if (rayAngle > 180 && rayAngle < 270) {
+    
+      // Vertical collision check setup
+      vccCosBy128 = pgm_read_byte(cosBy128 + (rayAngle - 180));
+      vccSinBy128 = pgm_read_byte(cosBy128 + (270 - rayAngle));
+      if (rayAngle == 270) vccTanByBlockSize = 0; else vccTanByBlockSize = (vccSinBy128 << MULTIPLY_BY_BLOCK_SIZE) / vccCosBy128; // tan = sin/cos with avoiding a divide by zero
+      vccStepX = -BLOCK_SIZE; 	
+      vccStepY = -vccTanByBlockSize; 
+      vccX = player.x - (player.x & (BLOCK_SIZE - 1)) - 1; // Equals to "vccX = player.x - (player.x % BLOCK_SIZE) - 1;"
+      tempLong = player.x - vccX;
+      tempLong = tempLong * vccTanByBlockSize;
+      vccY = player.y - (tempLong >> DIVIDE_BY_BLOCK_SIZE);
+      vccTextureOrient = TEXTURE_ORIENT_RIGHT_TO_LEFT;
+    
+      // Horizontal collision check setup
+      hccCosBy128 = pgm_read_byte(cosBy128 + (270 - rayAngle));
+      hccSinBy128 = pgm_read_byte(cosBy128 + (rayAngle - 180)); 
+      if (rayAngle == 180) hccTanByBlockSize = 0; else hccTanByBlockSize = (hccSinBy128 << MULTIPLY_BY_BLOCK_SIZE) / hccCosBy128; // tan = sin/cos with avoiding a divide by zero   
+      hccStepY = -BLOCK_SIZE;	
+      hccStepX = -hccTanByBlockSize; 
+      hccY = player.y - (player.y & (BLOCK_SIZE - 1)) - 1; // Equals to "hccY = player.y - (player.y % BLOCK_SIZE) - 1;"
+      tempLong = player.y - hccY;
+      tempLong = tempLong * hccTanByBlockSize;
+      hccX = player.x - (tempLong >> DIVIDE_BY_BLOCK_SIZE);
+      hccTextureOrient = TEXTURE_ORIENT_LEFT_TO_RIGHT; 
+    }
+  
+    // If the ray is in the fourth quadrant (top right on the cartesian coordinate system)
+    else { 
+
+      // Vertical collision check setup
+      vccCosBy128 = pgm_read_byte(cosBy128 + (360 - rayAngle));
+      vccSinBy128 = pgm_read_byte(cosBy128 + (rayAngle - 270));
+      if (rayAngle == 270) vccTanByBlockSize = 0; else vccTanByBlockSize = (vccSinBy128 << MULTIPLY_BY_BLOCK_SIZE) / vccCosBy128; // tan = sin/cos with avoiding a divide by zero
+      vccStepX = BLOCK_SIZE; 	
+      vccStepY = -vccTanByBlockSize; 
+      vccX = player.x + BLOCK_SIZE - (player.x & (BLOCK_SIZE - 1)); // Equals to "vccX = player.x + BLOCK_SIZE - (player.x % BLOCK_SIZE);"
+      tempLong = vccX - player.x;
+      tempLong = tempLong * vccTanByBlockSize;
+      vccY = player.y - (tempLong >> DIVIDE_BY_BLOCK_SIZE);
+      vccTextureOrient = TEXTURE_ORIENT_LEFT_TO_RIGHT;
+
+      // Horizontal collision check setup
+      hccCosBy128 = pgm_read_byte(cosBy128 + (rayAngle - 270));
+      hccSinBy128 = pgm_read_byte(cosBy128 + (360 - rayAngle));
+      if (rayAngle == 360) hccTanByBlockSize = 0; else hccTanByBlockSize = (hccSinBy128 << MULTIPLY_BY_BLOCK_SIZE) / hccCosBy128; // tan = sin/cos with avoiding a divide by zero
+      hccStepY = -BLOCK_SIZE;	
+      hccStepX = hccTanByBlockSize; 
+      hccY = player.y - (player.y & (BLOCK_SIZE - 1)) - 1; // Equals to "hccY = player.y - (player.y % BLOCK_SIZE) - 1;"
+      tempLong = player.y - hccY;
+      tempLong = tempLong * hccTanByBlockSize;
+      hccX = player.x + (tempLong >> DIVIDE_BY_BLOCK_SIZE);
+      hccTextureOrient = TEXTURE_ORIENT_LEFT_TO_RIGHT; 
+    }
+  
+    
+    // A vertical ray never crosses a vertical grid line, and a horizontal ray never crosses a horizontal grid line : the collision check is disabled by
+    // starting it outside of the world, so the collision check loops do not test the ray angle
+    if (rayAngle == 90 || rayAngle == 270) vccY = -1;
+    if (rayAngle == 0 || rayAngle == 180) hccX = -1;
+  }
+  
+  // The view distance bounds the number of grid lines each collision check crosses, whatever the world map. A grid line at D along the axis of a 
+  // collision check is at D * 128 / cos along the ray. An angle ray length is also divided by the fishbowl correction, so its cutoff is farther.
+  if (viewDistance && view >= VIEW_3D_SOLID) {
+    
+    tempLong = viewDistance;
+    if (!planeRay) tempLong = (tempLong << MULTIPLY_BY_128) / pgm_read_byte(cosBy128 + abs(rayNumber - viewportCentreRay));
+    vccStepsLeft = (((tempLong * vccCosBy128) >> DIVIDE_BY_128) + BLOCK_SIZE - abs(vccX - player.x)) >> DIVIDE_BY_BLOCK_SIZE;
+    hccStepsLeft = (((tempLong * hccCosBy128) >> DIVIDE_BY_128) + BLOCK_SIZE - abs(hccY - player.y)) >> DIVIDE_BY_BLOCK_SIZE;
+  }
+   
+  // Find the blocks hit by the ray and render them, from the nearest to the farthest. Without block heights, or when the column is covered, only
+  // the nearest block is rendered.
+  while (moreHits) {
+    
+    // Vertical collision check. The positions are tested as unsigned values, so one comparison tests both borders of an axis. In an enclosed world map,
+    // the border blocks stop the check before the X position leaves the world, so only the Y position is tested.
+    while (vccStepsLeft && (uint16_t)vccY < worldHeight && (enclosed || (uint16_t)vccX < worldWidth)) {
+    
+      ARCE_PROFILE_COUNT(vccSteps, 1);
+      ARCE_PROFILE_COUNT(mapReads, 1);
+    
+      // Get block from world map
+      blockXOnMap = vccX >> DIVIDE_BY_BLOCK_SIZE;
+      blockYOnMap = vccY >> DIVIDE_BY_BLOCK_SIZE;
+      vccBlockType = ARCE_READ_BYTE(worldMap + blockYOnMap * worldMapWidth + blockXOnMap);
+
+      // If the block is solid (wall, door, ...)
+      if (vccBlockType > 0) {
+      
+        // Save ray length and stop collision check
+        tempLong = vccX - player.x;
+        tempLong = tempLong << MULTIPLY_BY_128;
+        vccRayLength = abs(tempLong / vccCosBy128);
+        break;
+      }
+    
+      // Go to the next block
+      vccX += vccStepX;
+      vccY += vccStepY;
+      vccStepsLeft--;
+    }
+  
+    // Horizontal collision check. In an enclosed world map, the border blocks stop the check before the Y position leaves the world, so only the X 
+    // position is tested.
+    while (hccStepsLeft && (uint16_t)hccX < worldWidth && (enclosed || (uint16_t)hccY < worldHeight)) {
+    
+      ARCE_PROFILE_COUNT(hccSteps, 1);
+      ARCE_PROFILE_COUNT(mapReads, 1);
+    
+      // Get block from world map 
+      blockXOnMap = hccX >> DIVIDE_BY_BLOCK_SIZE; 
+      blockYOnMap = hccY >> DIVIDE_BY_BLOCK_SIZE;  
+      hccBlockType = ARCE_READ_BYTE(worldMap + blockYOnMap * worldMapWidth + blockXOnMap);
+    
+      // If the block is solid (wall, door, ...)
+      if (hccBlockType > 0) {
+      
+        // Save ray length and stop collision check
+        tempLong = hccY - player.y;
+        tempLong = tempLong << MULTIPLY_BY_128; 
+        hccRayLength = abs(tempLong / hccCosBy128);
+        break;
+      }
+    
+      // Go to the next block
+      hccX += hccStepX;
+      hccY += hccStepY;
+      hccStepsLeft--;
+    }
+  
+    // Choose shortest ray between vertical collision check ray and horizontal collision check ray
+    if (hccRayLength < vccRayLength) {
+        
+      rayLength = hccRayLength;
+      blockHitX = hccX;
+      blockHitY = hccY;
+      blockType = hccBlockType;
+      blockHitOffset = blockHitX & (BLOCK_SIZE - 1); // Equals to "blockHitOffset = blockHitX % BLOCK_SIZE;"
+      if (hccTextureOrient == TEXTURE_ORIENT_RIGHT_TO_LEFT) {
+      
+        blockHitOffset = (BLOCK_SIZE - 1) - blockHitOffset;
+      }
+    }
+    else {
+    
+      rayLength = vccRayLength; 
+      blockHitX = vccX;
+      blockHitY = vccY;
+      blockType = vccBlockType;
+
+      blockHitOffset = blockHitY & (BLOCK_SIZE - 1); // Equals to "blockHitOffset = blockHitY % BLOCK_SIZE;"
+      if (vccTextureOrient == TEXTURE_ORIENT_RIGHT_TO_LEFT) {
+      
+        blockHitOffset = (BLOCK_SIZE - 1) - blockHitOffset;
+      }
+    }
+  
+    
+    ARCE_PROFILE_STOP(trace);
+    ARCE_PROFILE_START(raster);
+    
+    // Blocks behind the nearest one are only rendered when something was hit. In a 3D view, a ray which hits nothing before the view distance or the
+    // world border leaves its column to the background.
+    if (blockType == 0 && (!nearestHit || view >= VIEW_3D_SOLID)) {
+      
+      moreHits = false;
+    }
+    
+    // If the current view is the VIEW_2D_ONERAY view
+    else if (view == VIEW_2D_ONERAY) {
+    
+        // Draw the current ray on the screen
+        if (rayLength) {
+    
+          drawLine((player.x >> (MULTIPLY_BY_BLOCK_SIZE - mapZoom)) - mapScrollX, (player.y >> (MULTIPLY_BY_BLOCK_SIZE - mapZoom)) - mapScrollY, 
+                   (blockHitX >> (MULTIPLY_BY_BLOCK_SIZE - mapZoom)) - mapScrollX, (blockHitY >> (MULTIPLY_BY_BLOCK_SIZE - mapZoom)) - mapScrollY);
+        }
+    }
+  
+    // If the current view is the VIEW_2D view
+    else if (view == VIEW_2D) {
+    
+      // Fill the field of view between the previous ray hit and this ray hit : the rays hits make a visibility polygon around the player, filled 
+      // triangle by triangle. The triangles share their edges, so each pixel is written once (a few pixels can be written twice where two close hits 
+      // are swapped by the rounding of the ray steps)
+      hitXOnMap = ((int16_t)blockHitX >> (MULTIPLY_BY_BLOCK_SIZE - mapZoom - MAP_SUBPIXEL_BITS)) - (mapScrollX << MAP_SUBPIXEL_BITS);
+      hitYOnMap = ((int16_t)blockHitY >> (MULTIPLY_BY_BLOCK_SIZE - mapZoom - MAP_SUBPIXEL_BITS)) - (mapScrollY << MAP_SUBPIXEL_BITS);
+      if (rayNumber > 0) {
+      
+        fillTriangle((player.x >> (MULTIPLY_BY_BLOCK_SIZE - mapZoom - MAP_SUBPIXEL_BITS)) - (mapScrollX << MAP_SUBPIXEL_BITS), 
+                     (player.y >> (MULTIPLY_BY_BLOCK_SIZE - mapZoom - MAP_SUBPIXEL_BITS)) - (mapScrollY << MAP_SUBPIXEL_BITS), 
+                     previousHitX, previousHitY, hitXOnMap, hitYOnMap);
+      }
+      previousHitX = hitXOnMap;
+      previousHitY = hitYOnMap;
+    }
+    
+    // If the current view is a 3D view
+    else {
+      
+      // Apply a "Fishbowl effect correction" on the ray length (correct distance = distorted distance * cos(angle)). The length of a camera plane ray
+      // is already the perpendicular distance.
+      if (!planeRay) {
+        
+        tempLong = rayLength;
+        tempLong = tempLong * pgm_read_byte(cosBy128 + abs(rayNumber - viewportCentreRay));
+        rayLength = tempLong >> DIVIDE_BY_128;
+      }
+      
+      // See-through blocks (bars, windows...) do not stop the ray. From the first one, the rows rendered by the ray are saved in a coverage mask, so 
+      // the blocks behind are only rendered in the rows which are not covered yet.
+      transparentHit = view == VIEW_3D_TEXTURED && transparentHits < TRANSPARENT_MAX_HITS && (ARCE_READ_BYTE(texturesArray[blockType - 1] + 3) & TEXTURE_MASKED);
+      if (transparentHit) {
+        
+        transparentHits++;
+        if (!coverageMasking) memcpy(sliceCoverage, viewportCoverage, sizeof(sliceCoverage));
+        coverageMasking = true;
+      }
+      
+      // Read the baked light of the face hit : one light map read for the column
+      if ((shadingMode & SHADING_LIGHT_MAP) && lightMap) {
+        
+        if (hccRayLength < vccRayLength) lightFace = hccStepY > 0 ? LIGHT_FACE_NORTH : LIGHT_FACE_SOUTH;
+        else lightFace = vccStepX > 0 ? LIGHT_FACE_WEST : LIGHT_FACE_EAST;
+        lightLevel = (ARCE_READ_BYTE(lightMap + (blockHitY >> DIVIDE_BY_BLOCK_SIZE) * worldMapWidth + (blockHitX >> DIVIDE_BY_BLOCK_SIZE)) >> (lightFace << 1)) & LIGHT_LEVEL_MASK;
+      }
+      
+      // Render the slice and tell if the blocks behind can still be seen
+      moreHits = drawWallSlice(rayNumber, rayLength, blockType, blockHitOffset, hccRayLength < vccRayLength, lightLevel, transparentHit, &coverageTopY);
+      
+      // The ray also stops when the see-through blocks cover its whole column
+      if (transparentHit) {
+        
+        moreHits = false;
+        for (uint8_t page=0; page<(SCREEN_HEIGHT >> DIVIDE_BY_8); page++) {
+          
+          if (sliceCoverage[page] != 0xFF) {
+            
+            moreHits = true;
+            break;
+          }
+        }
+      }
+    }
+    
+    ARCE_PROFILE_STOP(raster);
+    
+    if (view == VIEW_2D_ONERAY || view == VIEW_2D || !moreHits) break;
+    
+    // Nothing is seen behind the border blocks of an enclosed world map : the collision checks would leave the world without noticing it
+    if (enclosed && (blockHitX < BLOCK_SIZE || blockHitY < BLOCK_SIZE || blockHitX >= worldWidth - BLOCK_SIZE || blockHitY >= worldHeight - BLOCK_SIZE)) break;
+    
+    ARCE_PROFILE_RESTART(trace); // Stopped again at the top of the next iteration
+    
+    // Go on behind the rendered block. The collision check of the other axis finds its block again.
+    nearestHit = false;
+    if (hccRayLength < vccRayLength) {
+      
+      hccX += hccStepX;
+      hccY += hccStepY;
+      hccStepsLeft--;
+      hccRayLength = worldWidth;
+      hccBlockType = 0;
+    }
+    else {
+      
+      vccX += vccStepX;
+      vccY += vccStepY;
+      vccStepsLeft--;
+      vccRayLength = worldWidth;
+      vccBlockType = 0;
+    }
+  }
+  
+  // A wide slice (low resolution) also covers the next rays
+  for (uint8_t coveredRay=rayNumber + 1; coveredRay<rayNumber + rayStep; coveredRay++) {
+    
+    sliceTopY[coveredRay] = sliceTopY[rayNumber];
+    sliceBottomY[coveredRay] = sliceBottomY[rayNumber];
+  }
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Render the slice of a block hit by a ray in a 3D view. The slice is only rendered above the rows already covered by the nearer blocks 
+// (coverageTopY), which is then updated unless the block is a see-through block. Returns true if the blocks behind can still be seen.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+bool ARCE::drawWallSlice(uint8_t rayNumber, uint16_t rayLength, uint8_t blockType, uint8_t blockHitOffset, bool horizontalHit, uint8_t lightLevel, bool transparent, int16_t *coverageTopY) {
+  
+  uint16_t fullSliceHeight = 0;           // Height of the projected slice of a BLOCK_SIZE high block at this distance (screen coordinates).
+  int16_t fullSliceY = 0;                 // Y position of the projected slice of a BLOCK_SIZE high block at this distance (screen coordinates).
   uint16_t projectedSliceHeight = 0;      // Height of the projected slice (screen coordinates).
   int16_t projectedSliceY = 0;            // Y position of the projected slice. This value can be outside of the screen (screen coordinates).
-  uint8_t projectedSliceRenderStartY = 0; // Y position where the slice rendering process has to start. This value is always on the screen (screen coordinates).
-  uint8_t projectedSliceRenderStopY = 0;  // Y position where the slice rendering process has to stop. This value is always on the screen (screen coordinates).
-  uint8_t projectedTexelY = 0;            // Y position of the projected texel (screen coordinates).
+  int16_t sliceTop = 0;                   // Y position of the first row rendered (screen coordinates).
+  int16_t sliceBottom = 0;                // Y position of the last row rendered (screen coordinates).
   uint8_t projectedSliceX = 0;            // X position of the projected slice (screen coordinates).
+  uint8_t firstVisibleY = viewportY;      // Y position of the first row of the column inside the viewport and not under the minimap (screen coordinates).
+  uint8_t shadeBand = 0;                  // Shade band of the projected slice (see the shadeBands and shadeMasks arrays).
+  int32_t tempLong;                       // Variable used for 24 or 32 bits operations (sometimes only...). 
+  
+  // -----------------------------------------
+  // Render 3D view on the screen (projection)
+  // -----------------------------------------
+ 
+  // Calculate the projected slice height
+  //
+  //                                                Slice height (word coordinates) * Distance to projection plane (screen coordinates)
+  // Projected slice height (screen coordinates)  = ----------------------------------------------------------------------------------- 
+  //                                                                   Distance to the slice (word coordinates)
+  //
+  // Slice height = BLOCK_SIZE = 64
+  //
+  // Field of view = FOV = 64
+  // FOV / 2 = HALF_FOV = 32
+  // Screen width = SCREEN_WIDTH = 128
+  // Screen width / 2 = HALF_SCREEN_WIDTH = 64
+  // HALF_SCREEN_WIDTH / tan(HALF_FOV) = 64 / tan(32) = 102 = Distance to projection plane
+  //
+  // Distance to the slice = rayLength
+  //
+  //                           BLOCK_SIZE * 102     64 * 102        6528        PROJECTION_K
+  // Projected Slice Height = ------------------ = ----------- = ----------- = --------------
+  //                               rayLength        rayLength     rayLength      rayLength
+  //
+  if (rayLength == 0) {
+    
+    fullSliceHeight = PROJECTION_K;
+  }
+  else {
+     
+     fullSliceHeight = PROJECTION_K / rayLength;
+  }
+  fullSliceY = horizonY - (fullSliceHeight >> DIVIDE_BY_2);
+  
+  // Blocks stand on the floor : a block lower or higher than BLOCK_SIZE keeps the bottom of a BLOCK_SIZE high slice
+  projectedSliceHeight = fullSliceHeight;
+  projectedSliceY = fullSliceY;
+  if (blockHeights) {
+    
+    tempLong = fullSliceHeight;
+    projectedSliceHeight = (tempLong * ARCE_READ_BYTE(blockHeights + blockType - 1)) >> DIVIDE_BY_BLOCK_SIZE;
+    projectedSliceY += fullSliceHeight - projectedSliceHeight;
+  }
+  
+  // Calculate the X position of the projected slice on the screen
+  projectedSliceX = rayNumber << MULTIPLY_BY_2;
+  
+  // The rows under the minimap are not rendered
+  if (minimap && projectedSliceX >= minimapX && projectedSliceX < minimapX + MINIMAP_WIDTH && firstVisibleY < MINIMAP_HEIGHT) firstVisibleY = MINIMAP_HEIGHT;
+  
+  // Find the rows of the slice to render : inside the viewport, outside of the minimap, and above the rows covered by the nearer blocks
+  sliceTop = projectedSliceY;
+  sliceBottom = projectedSliceY + projectedSliceHeight - 1;
+  if (sliceTop < firstVisibleY) sliceTop = firstVisibleY;
+  if (sliceBottom > viewportStopY - 1) sliceBottom = viewportStopY - 1;
+  if (sliceBottom >= *coverageTopY) sliceBottom = *coverageTopY - 1;
+  
+  if (projectedSliceHeight > 0 && sliceTop <= sliceBottom) {
+    
+    // Save the rows covered by the slices for the floor and ceiling rendering : the floor is rendered below the first rendered slice, the ceiling 
+    // above all the slices. A see-through block does not cover its rows for the blocks behind.
+    if (sliceTopY[rayNumber] == SCREEN_HEIGHT) sliceBottomY[rayNumber] = sliceBottom;
+    if (sliceTop < sliceTopY[rayNumber]) sliceTopY[rayNumber] = sliceTop;
+    if (!transparent) *coverageTopY = sliceTop;
+    
+    // Mark the pages of the slice for the dirty tracking : all the writes of drawSliceByte() are inside these rows
+    dirtyPages |= (0xFF << (sliceTop >> DIVIDE_BY_8)) & (0xFF >> (7 - (sliceBottom >> DIVIDE_BY_8)));
+    
+    // Choose the shade band of the slice : one table read for the distance, one band darker for the horizontal collisions, the baked light level
+    // of the block face, and up to all the bands in the fog band before the view distance
+    shadeBand = lightLevel;
+    if (shadingMode & SHADING_DISTANCE) {
+      
+      tempLong = rayLength >> DIVIDE_BY_BLOCK_SIZE;
+      if (tempLong >= SHADE_BAND_COUNT) tempLong = SHADE_BAND_COUNT - 1;
+      shadeBand += pgm_read_byte(shadeBands + tempLong);
+    }
+    if ((shadingMode & SHADING_SIDE) && horizontalHit) shadeBand++;
+    if ((shadingMode & SHADING_FOG) && viewDistance) {
+      
+      tempLong = (int32_t)rayLength + FOG_BAND_SIZE - viewDistance;
+      if (tempLong > 0) shadeBand += (tempLong * (SHADE_DARKEST_BAND + 1)) >> DIVIDE_BY_FOG_BAND_SIZE;
+    }
+    if (shadeBand > SHADE_DARKEST_BAND) shadeBand = SHADE_DARKEST_BAND;
+    
+    // If the view is the VIEW_3D_SOLID view
+    if (view == VIEW_3D_SOLID) {
+      
+      // Render a solid slice
+      drawSliceSpan(projectedSliceX, sliceTop, sliceBottom, 0xFF, shadeBand);
+    }
+    
+    // If the view is the VIEW_3D_TEXTURED view
+    else {
+      
+      // Render a textured slice (the texture is stretched over the block height)
+      drawTexturedSlice(texturesArray[blockType - 1], blockHitOffset, projectedSliceX, projectedSliceY, projectedSliceHeight, sliceTop - projectedSliceY, sliceBottom - projectedSliceY, shadeBand);
+    }
+  }
+  
+  // The blocks behind are hidden when the column is covered up to its first visible row, or when the highest block would not reach above the covered
+  // rows at this distance (the top of a block higher than half a block moves down to the horizon with the distance)
+  if (transparent) return *coverageTopY > firstVisibleY;
+  if (!blockHeights || *coverageTopY <= firstVisibleY) return false;
+  tempLong = fullSliceHeight;
+  if (maxBlockHeight >= (BLOCK_SIZE >> DIVIDE_BY_2) && fullSliceY + fullSliceHeight - ((tempLong * maxBlockHeight) >> DIVIDE_BY_BLOCK_SIZE) >= *coverageTopY) return false;
+  return true;
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Fill a triangle into the screen buffer, row by row. The vertices positions have MAP_SUBPIXEL_BITS fractional bits. A pixel is filled when its centre
+// is inside the triangle, with the top and left edges included and the bottom and right edges excluded : two triangles sharing an edge never fill the
+// same pixel, and there is no gap between them.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+void ARCE::fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
+  
+  int16_t swapValue = 0;        // Value used to swap two vertices.
+  int16_t firstRow = 0;         // First row filled (screen coordinates).
+  int16_t middleRow = 0;        // First row of the lower part of the triangle, below the middle vertex (screen coordinates).
+  int16_t stopRow = 0;          // Row after the last row filled (screen coordinates).
+  int32_t longEdgeX = 0;        // X position of the edge from the top vertex to the bottom vertex on the current row (MAP_SUBPIXEL_BITS + 8 fractional bits).
+  int32_t longEdgeStep = 0;     // Step of the long edge X position between two rows.
+  int32_t shortEdgeX = 0;       // X position of the edge of the current part of the triangle on the current row (MAP_SUBPIXEL_BITS + 8 fractional bits).
+  int32_t shortEdgeStep = 0;    // Step of the short edge X position between two rows.
+  int16_t spanStartX = 0;       // First column of the current row span (screen coordinates).
+  int16_t spanStopX = 0;        // Column after the last column of the current row span (screen coordinates).
+  uint8_t *page;                // Screen buffer page of the current row.
+  uint8_t rowBit = 0;           // Bit of the current row in a screen buffer byte.
+  
+  // Sort the vertices from top to bottom
+  if (y1 < y0) { swapValue = x0; x0 = x1; x1 = swapValue; swapValue = y0; y0 = y1; y1 = swapValue; }
+  if (y2 < y1) { swapValue = x1; x1 = x2; x2 = swapValue; swapValue = y1; y1 = y2; y2 = swapValue; }
+  if (y1 < y0) { swapValue = x0; x0 = x1; x1 = swapValue; swapValue = y0; y0 = y1; y1 = swapValue; }
+  
+  // Find the rows whose centre is between the top vertex (included) and the bottom vertex (excluded), inside the screen
+  firstRow = (y0 + (1 << (MAP_SUBPIXEL_BITS - 1)) - 1) >> MAP_SUBPIXEL_BITS; // Equals to ceil(y0 - 0.5) in screen coordinates
+  middleRow = (y1 + (1 << (MAP_SUBPIXEL_BITS - 1)) - 1) >> MAP_SUBPIXEL_BITS;
+  stopRow = (y2 + (1 << (MAP_SUBPIXEL_BITS - 1)) - 1) >> MAP_SUBPIXEL_BITS;
+  if (firstRow < 0) firstRow = 0;
+  if (stopRow > SCREEN_HEIGHT) stopRow = SCREEN_HEIGHT;
+  if (middleRow < firstRow) middleRow = firstRow;
+  if (middleRow > stopRow) middleRow = stopRow;
+  if (firstRow >= stopRow) return;
+  
+  longEdgeX = getEdgeX(x0, y0, x2, y2, firstRow, &longEdgeStep);
+  
+  for (int16_t row=firstRow; row<stopRow; row++) {
+    
+    // Each edge starts on the row of its top vertex, so an edge shared by two triangles has the same positions in both triangles
+    if (row == firstRow || row == middleRow) {
+      
+      if (row < middleRow) shortEdgeX = getEdgeX(x0, y0, x1, y1, row, &shortEdgeStep);
+      else shortEdgeX = getEdgeX(x1, y1, x2, y2, row, &shortEdgeStep);
+    }
+    
+    // Find the columns whose centre is between the edges : left edge included, right edge excluded
+    if (longEdgeX < shortEdgeX) {
+      
+      spanStartX = ((longEdgeX >> 8) + (1 << (MAP_SUBPIXEL_BITS - 1)) - 1) >> MAP_SUBPIXEL_BITS;
+      spanStopX = ((shortEdgeX >> 8) + (1 << (MAP_SUBPIXEL_BITS - 1)) - 1) >> MAP_SUBPIXEL_BITS;
+    }
+    else {
+      
+      spanStartX = ((shortEdgeX >> 8) + (1 << (MAP_SUBPIXEL_BITS - 1)) - 1) >> MAP_SUBPIXEL_BITS;
+      spanStopX = ((longEdgeX >> 8) + (1 << (MAP_SUBPIXEL_BITS - 1)) - 1) >> MAP_SUBPIXEL_BITS;
+    }
+    if (spanStartX < 0) spanStartX = 0;
+    if (spanStopX > SCREEN_WIDTH) spanStopX = SCREEN_WIDTH;
+    
+    // Fill the span
+    page = buffer + ((row >> DIVIDE_BY_8) << MULTIPLY_BY_128);
+    rowBit = 1 << (row & 7); // Equals to 1 << (row % 8)
+    if (spanStopX > spanStartX) dirtyPages |= 1 << (row >> DIVIDE_BY_8);
+    for (int16_t x=spanStartX; x<spanStopX; x++) page[x] |= rowBit;
+    ARCE_PROFILE_COUNT(pixelsWritten, spanStopX > spanStartX ? spanStopX - spanStartX : 0);
+    
+    longEdgeX += longEdgeStep;
+    shortEdgeX += shortEdgeStep;
+  }
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Get the X position of a triangle edge at the centre of a given row, with MAP_SUBPIXEL_BITS + 8 fractional bits, and its step between two rows.
+// The edge must cross the row (bottomY > topY).
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+int32_t ARCE::getEdgeX(int16_t topX, int16_t topY, int16_t bottomX, int16_t bottomY, int16_t row, int32_t *step) {
+  
+  int16_t rowCentreY = (row << MAP_SUBPIXEL_BITS) + (1 << (MAP_SUBPIXEL_BITS - 1)); // Y position of the row centre (MAP_SUBPIXEL_BITS fractional bits).
+  
+  *step = ((int32_t)(bottomX - topX) << (8 + MAP_SUBPIXEL_BITS)) / (bottomY - topY);
+  return ((int32_t)topX + (int32_t)(rowCentreY - topY) * (bottomX - topX) / (bottomY - topY)) << 8;
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Render a textured slice. The texture descriptor is read once and the texel addressing is prepared once for the whole slice, so the render loop 
+// only steps inside a texture column.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+void ARCE::drawTexturedSlice(const uint8_t *texture, uint8_t blockHitOffset, uint8_t projectedSliceX, int16_t projectedSliceY, uint16_t projectedSliceHeight, 
+                             uint16_t projectedSliceRenderStartY, uint16_t projectedSliceRenderStopY, uint8_t shadeBand) {
+  
+  uint8_t textureWidthShift = 0;          // Texture width, as a power of 2 (texture width = 1 << textureWidthShift).
+  uint8_t textureHeightShift = 0;         // Texture height, as a power of 2 (texture height = 1 << textureHeightShift).
+  uint8_t textureFormat = 0;              // Texture packing format : TEXTURE_FORMAT_ROW_MAJOR or TEXTURE_FORMAT_COLUMN_MAJOR.
+  uint8_t textureFlags = 0;               // Texture flags : levels of detail count and TEXTURE_MASKED.
+  uint8_t textureLodCount = 0;            // Number of texture levels of detail after the full size texture (the last one is the average texel).
+  uint8_t textureLodLevel = 0;            // Level of detail used by the projected slice (0 is the full size texture).
+  const uint8_t *texels;                  // Texels of the texture level of detail used by the projected slice.
+  const uint8_t *mask = 0;                // Mask of the texture level of detail used by the projected slice (masked textures only).
+  uint16_t texelsSize = 0;                // Size of all the texture levels of detail (bytes). The mask of a masked texture starts after the texels.
+  uint8_t textureSliceX = 0;              // X position of the ray in the texture. That's the X position of texels in the texture used by the projected slice (texture coordinates).
   uint16_t textureSliceRenderStepByK = 0; // Step to make inside the texture used by the projected slice. This step is multiplied by K constant in order to use integers (texture coordinates).
+  uint16_t texelYByK = 0;                 // Y position of the texel in the texture, multiplied by K (texture coordinates).
   uint8_t texelY = 0;                     // Y position of the texel in the texture used by the projected slice (texture coordinates).
   uint16_t texelPosInTexture = 0;         // Position of the texel bit in the texture array.
-  uint8_t texelBytePosInTexture = 0;      // Position of the texel byte in the texture array.
-  uint8_t texelByte = 0;                  // Texel byte read from the texture array.
   uint8_t texelPosInTexelByte = 0;        // Texel position in the texel byte read from the texture array.
+  const uint8_t *texelColumn;             // First texel byte of the texture column used by the projected slice.
+  uint8_t texelRowSize = 0;               // Size of a texture row (bytes). Used by row-major textures.
   uint8_t texelByteMask = 0;              // Mask used to read texel bit from texel byte.
-  uint8_t texelByteReadWithMask = 0;      // Texel byte read with the texel mask byte.
+  uint8_t texelByte = 0;                  // Texel byte read from the texture array.
+  uint8_t texelBytePos = 0xFF;            // Position of the last texel byte read in the texture column. Used by column-major textures.
   uint8_t texel = 0;                      // Texel read from the texture : 0 or 1.
-  int32_t tempLong;                       // Variable used for 24 or 32 bits operations (sometimes only...). 
+  uint8_t texelMask = 1;                  // Mask texel read from the texture mask : 0 (transparent) or 1.
+  uint8_t projectedTexelY = 0;            // Y position of the projected texel (screen coordinates).
+  uint8_t sliceSpanMask = 0;              // Rows of the current screen buffer byte covered by the projected slice.
+  uint8_t slicePixels = 0;                // Pixels of the projected slice in the current screen buffer byte.
+  bool genericTexelAddressing = false;    // Tells if the texels of the projected slice are read with the generic (slower) texel addressing.
+  
+  // Read the texture descriptor
+  textureWidthShift = ARCE_READ_BYTE(texture);
+  textureHeightShift = ARCE_READ_BYTE(texture + 1);
+  textureFormat = ARCE_READ_BYTE(texture + 2);
+  textureFlags = ARCE_READ_BYTE(texture + 3);
+  textureLodCount = textureFlags & TEXTURE_LOD_COUNT_MASK;
+  texels = texture + TEXTURE_DESCRIPTOR_SIZE;
+  
+  // Choose the texture level of detail : the biggest level which is not higher than the projected slice.
+  // Distant slices then read less texels and do not shimmer.
+  while (textureLodLevel < textureLodCount && projectedSliceHeight < (1 << (textureHeightShift - textureLodLevel))) {
+    
+    if (textureFormat == TEXTURE_FORMAT_RLE) texels += ARCE_READ_WORD(texels + (2 << (textureWidthShift - textureLodLevel)));
+    else texels += getTextureLevelSize(textureWidthShift - textureLodLevel, textureHeightShift - textureLodLevel);
+    textureLodLevel++;
+  }
+  
+  if ((textureFlags & TEXTURE_MASKED) && textureFormat != TEXTURE_FORMAT_RLE) {
+    
+    texelsSize = getTextureLevelSize(textureWidthShift, textureHeightShift);
+    for (uint8_t level=1; level<textureLodCount; level++) texelsSize += getTextureLevelSize(textureWidthShift - level, textureHeightShift - level);
+    if (textureLodCount) texelsSize++;
+    mask = texels + texelsSize;
+  }
+  
+  // The average texel level is rendered as a solid slice
+  if (textureLodCount && textureLodLevel == textureLodCount) {
+    
+    if (!mask || ARCE_READ_BYTE(mask)) drawSliceSpan(projectedSliceX, projectedSliceY + projectedSliceRenderStartY, projectedSliceY + projectedSliceRenderStopY, ARCE_READ_BYTE(texels), shadeBand);
+    return;
+  }
+  textureWidthShift -= textureLodLevel;
+  textureHeightShift -= textureLodLevel;
+  
+  // The texture covers the block face whatever its size
+  textureSliceX = blockHitOffset >> (MULTIPLY_BY_BLOCK_SIZE - textureWidthShift);
+  
+  // Calculate texture slice render step
+  //
+  //                                  Texture height 
+  // Texture slice render step = ------------------------ 
+  //                              Projected slice height
+  //
+  //                                  Texture height * k              Texture height * K
+  // Texture slice render step = ---------------------------- = --------------------------
+  //                              Projected slice height * k     projectedSliceHeight * K
+  //
+  //                                  Texture height * K
+  // Texture slice render step * k = ----------------------
+  //                                 projectedSliceHeight
+  //
+  textureSliceRenderStepByK = (K << textureHeightShift) / projectedSliceHeight;
+  texelYByK = projectedSliceRenderStartY * textureSliceRenderStepByK;
+  
+  if (textureFormat == TEXTURE_FORMAT_RLE) {
+    
+    drawRleTexturedSlice(texels, textureSliceX, textureSliceRenderStepByK, projectedSliceX, projectedSliceY, projectedSliceRenderStartY, projectedSliceRenderStopY, shadeBand);
+    return;
+  }
+  
+  // Prepare the texel addressing once for the whole slice : the render loop only has to step inside a texture column.
+  // Masked textures and the textures whose columns do not start on a byte use the generic texel addressing.
+  if (mask || (textureFormat == TEXTURE_FORMAT_ROW_MAJOR && textureWidthShift < 3) || (textureFormat == TEXTURE_FORMAT_COLUMN_MAJOR && textureHeightShift < 3)) {
+    
+    genericTexelAddressing = true;
+  }
+  else if (textureFormat == TEXTURE_FORMAT_ROW_MAJOR) {
+    
+    texelRowSize = 1 << (textureWidthShift - 3);
+    texelColumn = texels + (textureSliceX >> DIVIDE_BY_8);
+    texelByteMask = 128 >> (textureSliceX & 7); // Equals to 128 >> (textureSliceX % 8)
+  }
+  else {
+    
+    texelColumn = texels + ((textureSliceX << textureHeightShift) >> DIVIDE_BY_8);
+  }
+  
+  // Render the textured slice on the screen. Texels are gathered into screen buffer bytes (8 rows) before being drawn.
+  for (uint16_t projectedSliceRenderY = projectedSliceRenderStartY; projectedSliceRenderY <= projectedSliceRenderStopY; projectedSliceRenderY++) {
+    
+    // Get pixel from the texture (get texel)
+    texelY = texelYByK >> DIVIDE_BY_K;
+    texelYByK += textureSliceRenderStepByK;
+    ARCE_PROFILE_COUNT(texelFetches, 1);
+    
+    if (genericTexelAddressing) {
+      
+      if (textureFormat == TEXTURE_FORMAT_ROW_MAJOR) texelPosInTexture = (texelY << textureWidthShift) + textureSliceX;
+      else texelPosInTexture = (textureSliceX << textureHeightShift) + texelY;
+      texelPosInTexelByte = 7 - (texelPosInTexture & 7); // Equals to 7 - (texelPosInTexture % 8)
+      texel = (ARCE_READ_BYTE(texels + (texelPosInTexture >> DIVIDE_BY_8)) >> texelPosInTexelByte) & 1;
+      if (mask) texelMask = (ARCE_READ_BYTE(mask + (texelPosInTexture >> DIVIDE_BY_8)) >> texelPosInTexelByte) & 1;
+    }
+    else if (textureFormat == TEXTURE_FORMAT_ROW_MAJOR) {
+      
+      texel = (ARCE_READ_BYTE(texelColumn + texelY * texelRowSize) & texelByteMask) != 0;
+    }
+    else {
+      
+      // Magnified slices read the same texel byte several times in a row
+      if ((texelY >> DIVIDE_BY_8) != texelBytePos) {
+        
+        texelBytePos = texelY >> DIVIDE_BY_8;
+        texelByte = ARCE_READ_BYTE(texelColumn + texelBytePos);
+      }
+      texel = (texelByte >> (7 - (texelY & 7))) & 1;
+    }
+    
+    // Add the texel to the current screen buffer byte. Transparent texels are not drawn.
+    projectedTexelY = projectedSliceY + projectedSliceRenderY;
+    sliceSpanMask |= texelMask << (projectedTexelY & 7);
+    slicePixels |= texel << (projectedTexelY & 7);
+    
+    // Draw the screen buffer byte when it is complete or when the slice ends
+    if ((projectedTexelY & 7) == 7 || projectedSliceRenderY == projectedSliceRenderStopY) {
+      
+      drawSliceByte(projectedSliceX, buffer + ((projectedTexelY >> DIVIDE_BY_8) << MULTIPLY_BY_128), sliceSpanMask, slicePixels, shadeBand);
+      sliceSpanMask = 0;
+      slicePixels = 0;
+    }
+  }
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Render a slice of an RLE texture. Each run of the texture column is projected as a solid span, so a near slice costs a few spans instead of
+// one texel read for each pixel.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+void ARCE::drawRleTexturedSlice(const uint8_t *texels, uint8_t textureSliceX, uint16_t textureSliceRenderStepByK, uint8_t projectedSliceX, int16_t projectedSliceY, 
+                                uint16_t projectedSliceRenderStartY, uint16_t projectedSliceRenderStopY, uint8_t shadeBand) {
+  
+  const uint8_t *run;                 // Current run of the texture column.
+  uint8_t runByte = 0;                // Current run byte : texels value and texels count.
+  uint8_t runStopTexelY = 0;          // Y position of the texel after the current run (texture coordinates).
+  uint16_t runStopRenderY = 0;        // Y position of the first slice row after the current run (slice coordinates).
+  uint8_t firstTexelY = 0;            // Y position of the texel of the first rendered row (texture coordinates).
+  uint16_t projectedSliceRenderY = projectedSliceRenderStartY; // Y position of the first row of the current span (slice coordinates).
+  
+  run = texels + ARCE_READ_WORD(texels + (textureSliceX << 1));
+  firstTexelY = (projectedSliceRenderStartY * textureSliceRenderStepByK) >> DIVIDE_BY_K;
+  
+  while (projectedSliceRenderY <= projectedSliceRenderStopY) {
+    
+    runByte = ARCE_READ_BYTE(run++);
+    ARCE_PROFILE_COUNT(texelFetches, 1);
+    runStopTexelY += runByte & TEXTURE_RLE_LENGTH_MASK;
+    
+    // Skip the runs above the rendered rows
+    if (runStopTexelY <= firstTexelY) continue;
+    
+    // The slice row R shows the texel (R * step) / K, so the run covers the rows lower than (runStopTexelY * K) / step
+    if (textureSliceRenderStepByK) runStopRenderY = (((uint16_t)runStopTexelY << MULTIPLY_BY_K) + textureSliceRenderStepByK - 1) / textureSliceRenderStepByK;
+    else runStopRenderY = projectedSliceRenderStopY + 1;
+    if (runStopRenderY > projectedSliceRenderStopY + 1) runStopRenderY = projectedSliceRenderStopY + 1;
+    
+    // Runs shorter than the render step can be skipped by all rows
+    if (runStopRenderY > projectedSliceRenderY) {
+      
+      drawSliceSpan(projectedSliceX, projectedSliceY + projectedSliceRenderY, projectedSliceY + runStopRenderY - 1, (runByte & TEXTURE_RLE_VALUE) ? 0xFF : 0, shadeBand);
+      projectedSliceRenderY = runStopRenderY;
+    }
+  }
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Write a solid span of a slice into the screen buffer, a screen buffer byte (8 rows) at a time.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+void ARCE::drawSliceSpan(uint8_t projectedSliceX, uint8_t startY, uint8_t stopY, uint8_t pixels, uint8_t shadeBand) {
   
-  // Ray angle should remain between 0 and 360 degrees
-  rayAngle %= 360;
-  if (rayAngle < 0) rayAngle += 360;
-  
-  // If the ray is in the first quadrant (bottom right on the cartesian coordinate system)
-  if (rayAngle >= 0 && rayAngle <= 90) {
-    
-    // Setup vertical collision check
-    vccCosBy128 = pgm_read_byte(cosBy128 + rayAngle);
-    vccSinBy128 = pgm_read_byte(cosBy128 + (90 - rayAngle)); 
-    if (rayAngle == 90) vccTanByBlockSize = 0; else vccTanByBlockSize = (vccSinBy128 << MULTIPLY_BY_BLOCK_SIZE) / vccCosBy128; // tan = sin/cos with avoiding a divide by zero
-    vccStepX = BLOCK_SIZE; 	
-    vccStepY = vccTanByBlockSize;
-    vccX = player.x + BLOCK_SIZE - (player.x & (BLOCK_SIZE - 1)); // Equals to "vccX = player.x + BLOCK_SIZE - (player.x % BLOCK_SIZE);"
-    tempLong = vccX - player.x; 
-    tempLong = tempLong * vccTanByBlockSize;
-    vccY = player.y + (tempLong >> DIVIDE_BY_BLOCK_SIZE);
-    vccTextureOrient = TEXTURE_ORIENT_LEFT_TO_RIGHT;
-    
-    // Setup horizontal collision check
-    hccCosBy128 = pgm_read_byte(cosBy128 + (90 - rayAngle));
-    hccSinBy128 = pgm_read_byte(cosBy128 + rayAngle);
-    if (rayAngle == 0) hccTanByBlockSize = 0; else hccTanByBlockSize = (hccSinBy128 << MULTIPLY_BY_BLOCK_SIZE) / hccCosBy128; // tan = sin/cos with avoiding a divide by zero
-    hccStepY = BLOCK_SIZE;	
-    hccStepX = hccTanByBlockSize; 
-    hccY = player.y + BLOCK_SIZE - (player.y & (BLOCK_SIZE - 1)); // Equals to "hccY = player.y + BLOCK_SIZE - (player.y % BLOCK_SIZE);"
-    tempLong = hccY - player.y;
-    tempLong = tempLong * hccTanByBlockSize;
-    hccX = player.x + (tempLong >> DIVIDE_BY_BLOCK_SIZE);
-    hccTextureOrient = TEXTURE_ORIENT_RIGHT_TO_LEFT;
+  uint8_t spanMask = 0; // Rows of the current screen buffer byte covered by the span.
+  
+  for (uint8_t page = startY >> DIVIDE_BY_8; page <= (stopY >> DIVIDE_BY_8); page++) {
+    
+    spanMask = 0xFF;
+    if (page == (startY >> DIVIDE_BY_8)) spanMask &= 0xFF << (startY & 7);
+    if (page == (stopY >> DIVIDE_BY_8)) spanMask &= 0xFF >> (7 - (stopY & 7));
+    drawSliceByte(projectedSliceX, buffer + (page << MULTIPLY_BY_128), spanMask, pixels, shadeBand);
   }
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Write the pixels of a slice into a screen buffer byte. The slice is sliceWidth pixels wide and only the rows of spanMask are written.
+// The pixels are dithered with the shade band mask, so the shading costs one AND operation for each byte.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+void ARCE::drawSliceByte(uint8_t projectedSliceX, uint8_t *page, uint8_t spanMask, uint8_t pixels, uint8_t shadeBand) {
   
-  // If the ray is in the second quadrant (bottom left on the cartesian coordinate system)
-  else if (rayAngle > 90 && rayAngle <= 180) {
+  const uint8_t *shadeMask = shadeMasks + (shadeBand << 2); // Dither masks of the shade band (one mask for each X position modulo 4).
+  uint8_t *coverage;                                        // Rows of the screen buffer byte already rendered by the current ray.
+  
+  // Behind a see-through block, the rows already rendered by the ray are not written again
+  if (coverageMasking) {
     
-    // Vertical collision check setup
-    vccCosBy128 = pgm_read_byte(cosBy128 + (180 - rayAngle));
-    vccSinBy128 = pgm_read_byte(cosBy128 + (rayAngle - 90));
-    if (rayAngle == 90) vccTanByBlockSize = 0; else vccTanByBlockSize = (vccSinBy128 << MULTIPLY_BY_BLOCK_SIZE) / vccCosBy128; // tan = sin/cos with avoiding a divide by zero
-    vccStepX = -BLOCK_SIZE; 	
-    vccStepY = vccTanByBlockSize;
-    vccX = player.x - (player.x & (BLOCK_SIZE - 1)) - 1; // Equals to "vccX = player.x - (player.x % BLOCK_SIZE) - 1;"
-    tempLong = player.x - vccX;
-    tempLong = tempLong * vccTanByBlockSize;
-    vccY = player.y + (tempLong >> DIVIDE_BY_BLOCK_SIZE);
-    vccTextureOrient = TEXTURE_ORIENT_RIGHT_TO_LEFT;
+    coverage = sliceCoverage + ((page - buffer) >> MULTIPLY_BY_128);
+    spanMask &= ~*coverage;
+    *coverage |= spanMask;
+  }
+  
+  ARCE_PROFILE_COUNT(pixelsWritten, __builtin_popcount(spanMask) * sliceWidth);
+  
+  pixels &= spanMask;
+  page[projectedSliceX] = (page[projectedSliceX] & ~spanMask) | (pixels & pgm_read_byte(shadeMask + (projectedSliceX & 3)));
+  page[projectedSliceX + 1] = (page[projectedSliceX + 1] & ~spanMask) | (pixels & pgm_read_byte(shadeMask + ((projectedSliceX + 1) & 3)));
+  
+  // Low resolution slices are 4 pixels wide
+  if (sliceWidth == 4) {
     
-    // Horizontal collision check setup
-    hccCosBy128 = pgm_read_byte(cosBy128 + (rayAngle - 90));
-    hccSinBy128 = pgm_read_byte(cosBy128 + (180 - rayAngle));
-    if (rayAngle == 180) hccTanByBlockSize = 0; else hccTanByBlockSize = (hccSinBy128 << MULTIPLY_BY_BLOCK_SIZE) / hccCosBy128; // tan = sin/cos with avoiding a divide by zero
-    hccStepY = BLOCK_SIZE;	
-    hccStepX = -hccTanByBlockSize; 
-    hccY = player.y + BLOCK_SIZE - (player.y & (BLOCK_SIZE - 1)); // Equals to "hccY = player.y + BLOCK_SIZE - (player.y % BLOCK_SIZE);"
-    tempLong = hccY - player.y;
-    tempLong = tempLong * hccTanByBlockSize;
-    hccX = player.x - (tempLong >> DIVIDE_BY_BLOCK_SIZE);
-    hccTextureOrient = TEXTURE_ORIENT_RIGHT_TO_LEFT; 
+    page[projectedSliceX + 2] = (page[projectedSliceX + 2] & ~spanMask) | (pixels & pgm_read_byte(shadeMask + ((projectedSliceX + 2) & 3)));
+    page[projectedSliceX + 3] = (page[projectedSliceX + 3] & ~spanMask) | (pixels & pgm_read_byte(shadeMask + ((projectedSliceX + 3) & 3)));
   }
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Render the floor and the ceiling of a 3D view, row by row, around the slices rendered by castRay().
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+void ARCE::castFloorAndCeiling() {
+  
+  int16_t anchorDirXBy128[(RAY_COUNT >> DIVIDE_BY_SURFACE_SEGMENT_SIZE) + 1]; // X direction of each anchor ray divided by the cosinus of its angle to the player orientation (multiplied by 128).
+  int16_t anchorDirYBy128[(RAY_COUNT >> DIVIDE_BY_SURFACE_SEGMENT_SIZE) + 1]; // Y direction of each anchor ray divided by the cosinus of its angle to the player orientation (multiplied by 128).
+  int8_t anchorAngle = 0;           // Angle between an anchor ray and the player orientation. Anchor rays are the rays where floor points are exactly calculated.
+  uint8_t anchorCosBy128 = 0;       // Cosinus of the angle between an anchor ray and the player orientation, multiplied by 128.
+  int16_t anchorOffset = 0;         // Distance between the centre of the projection and an anchor ray on the camera plane (screen coordinates).
+  int16_t forwardXBy128 = getCosBy128(player.rot);      // X direction of the player orientation, multiplied by 128.
+  int16_t forwardYBy128 = getCosBy128(player.rot - 90); // Y direction of the player orientation, multiplied by 128. Sin(A) = Cos(A - 90)
+  uint16_t rowDistance = 0;         // Straight distance between the player and the floor (or ceiling) points of the current row (world coordinates).
+  uint8_t floorY = 0;               // Y position of the current floor row (screen coordinates).
+  uint8_t ceilingY = 0;             // Y position of the current ceiling row (screen coordinates).
+  uint8_t *floorPage;               // Screen buffer page of the current floor row.
+  uint8_t *ceilingPage;             // Screen buffer page of the current ceiling row.
+  uint8_t floorBit = 0;             // Bit of the current floor row in a screen buffer byte.
+  uint8_t ceilingBit = 0;           // Bit of the current ceiling row in a screen buffer byte.
+  int32_t pointXBy256 = 0;          // X position of the current floor point, multiplied by 256 (world coordinates).
+  int32_t pointYBy256 = 0;          // Y position of the current floor point, multiplied by 256 (world coordinates).
+  int32_t nextAnchorPointXBy256 = 0; // X position of the floor point of the next anchor ray, multiplied by 256 (world coordinates).
+  int32_t nextAnchorPointYBy256 = 0; // Y position of the floor point of the next anchor ray, multiplied by 256 (world coordinates).
+  int32_t pointStepXBy256 = 0;      // X step between the floor points of two consecutive rays, multiplied by 256 (world coordinates).
+  int32_t pointStepYBy256 = 0;      // Y step between the floor points of two consecutive rays, multiplied by 256 (world coordinates).
+  int32_t playerXBy256 = (int32_t)player.x << 8; // X position of the player, multiplied by 256 (world coordinates).
+  int32_t playerYBy256 = (int32_t)player.y << 8; // Y position of the player, multiplied by 256 (world coordinates).
+  uint8_t rayNumber = 0;            // Number of the ray (slice) of the current floor point.
+  uint8_t projectedSliceX = 0;      // X position of the slice of the current floor point (screen coordinates).
+  uint8_t floorWidthShift = 0;      // Floor texture width, as a power of 2.
+  uint8_t floorHeightShift = 0;     // Floor texture height, as a power of 2.
+  uint8_t ceilingWidthShift = 0;    // Ceiling texture width, as a power of 2.
+  uint8_t ceilingHeightShift = 0;   // Ceiling texture height, as a power of 2.
+  bool ceilingRow = false;          // Tells if the current ceiling row is rendered : inside the viewport, with a ceiling mode.
+  bool minimapRow = false;          // Tells if the current ceiling row is partly under the minimap.
+  uint8_t firstAnchor = viewportFirstRay >> DIVIDE_BY_SURFACE_SEGMENT_SIZE; // First anchor ray of the viewport.
+  uint8_t lastAnchor = (viewportStopRay + SURFACE_SEGMENT_SIZE - 1) >> DIVIDE_BY_SURFACE_SEGMENT_SIZE; // Last anchor ray of the viewport.
   
-  // If the ray is in the third quadrant (top left on the cartesian coordinate system)
-  else if (rayAngle > 180 && rayAngle < 270) {
+  ARCE_PROFILE_START(raster);
+  
+  // Read the surfaces textures descriptors
+  if (floorMode == SURFACE_TEXTURED) {
     
-    // Vertical collision check setup
-    vccCosBy128 = pgm_read_byte(cosBy128 + (rayAngle - 180));
-    vccSinBy128 = pgm_read_byte(cosBy128 + (270 - rayAngle));
-    if (rayAngle == 270) vccTanByBlockSize = 0; else vccTanByBlockSize = (vccSinBy128 << MULTIPLY_BY_BLOCK_SIZE) / vccCosBy128; // tan = sin/cos with avoiding a divide by zero
-    vccStepX = -BLOCK_SIZE; 	
-    vccStepY = -vccTanByBlockSize; 
-    vccX = player.x - (player.x & (BLOCK_SIZE - 1)) - 1; // Equals to "vccX = player.x - (player.x % BLOCK_SIZE) - 1;"
-    tempLong = player.x - vccX;
-    tempLong = tempLong * vccTanByBlockSize;
-    vccY = player.y - (tempLong >> DIVIDE_BY_BLOCK_SIZE);
-    vccTextureOrient = TEXTURE_ORIENT_RIGHT_TO_LEFT;
+    floorWidthShift = ARCE_READ_BYTE(floorTexture);
+    floorHeightShift = ARCE_READ_BYTE(floorTexture + 1);
+  }
+  if (ceilingMode == SURFACE_TEXTURED) {
     
-    // Horizontal collision check setup
-    hccCosBy128 = pgm_read_byte(cosBy128 + (270 - rayAngle));
-    hccSinBy128 = pgm_read_byte(cosBy128 + (rayAngle - 180)); 
-    if (rayAngle == 180) hccTanByBlockSize = 0; else hccTanByBlockSize = (hccSinBy128 << MULTIPLY_BY_BLOCK_SIZE) / hccCosBy128; // tan = sin/cos with avoiding a divide by zero   
-    hccStepY = -BLOCK_SIZE;	
-    hccStepX = -hccTanByBlockSize; 
-    hccY = player.y - (player.y & (BLOCK_SIZE - 1)) - 1; // Equals to "hccY = player.y - (player.y % BLOCK_SIZE) - 1;"
-    tempLong = player.y - hccY;
-    tempLong = tempLong * hccTanByBlockSize;
-    hccX = player.x - (tempLong >> DIVIDE_BY_BLOCK_SIZE);
-    hccTextureOrient = TEXTURE_ORIENT_LEFT_TO_RIGHT; 
+    ceilingWidthShift = ARCE_READ_BYTE(ceilingTexture);
+    ceilingHeightShift = ARCE_READ_BYTE(ceilingTexture + 1);
   }
   
-  // If the ray is in the fourth quadrant (top right on the cartesian coordinate system)
-  else { 
-
-    // Vertical collision check setup
-    vccCosBy128 = pgm_read_byte(cosBy128 + (360 - rayAngle));
-    vccSinBy128 = pgm_read_byte(cosBy128 + (rayAngle - 270));
-    if (rayAngle == 270) vccTanByBlockSize = 0; else vccTanByBlockSize = (vccSinBy128 << MULTIPLY_BY_BLOCK_SIZE) / vccCosBy128; // tan = sin/cos with avoiding a divide by zero
-    vccStepX = BLOCK_SIZE; 	
-    vccStepY = -vccTanByBlockSize; 
-    vccX = player.x + BLOCK_SIZE - (player.x & (BLOCK_SIZE - 1)); // Equals to "vccX = player.x + BLOCK_SIZE - (player.x % BLOCK_SIZE);"
-    tempLong = vccX - player.x;
-    tempLong = tempLong * vccTanByBlockSize;
-    vccY = player.y - (tempLong >> DIVIDE_BY_BLOCK_SIZE);
-    vccTextureOrient = TEXTURE_ORIENT_LEFT_TO_RIGHT;
-
-    // Horizontal collision check setup
-    hccCosBy128 = pgm_read_byte(cosBy128 + (rayAngle - 270));
-    hccSinBy128 = pgm_read_byte(cosBy128 + (360 - rayAngle));
-    if (rayAngle == 360) hccTanByBlockSize = 0; else hccTanByBlockSize = (hccSinBy128 << MULTIPLY_BY_BLOCK_SIZE) / hccCosBy128; // tan = sin/cos with avoiding a divide by zero
-    hccStepY = -BLOCK_SIZE;	
-    hccStepX = hccTanByBlockSize; 
-    hccY = player.y - (player.y & (BLOCK_SIZE - 1)) - 1; // Equals to "hccY = player.y - (player.y % BLOCK_SIZE) - 1;"
-    tempLong = player.y - hccY;
-    tempLong = tempLong * hccTanByBlockSize;
-    hccX = player.x + (tempLong >> DIVIDE_BY_BLOCK_SIZE);
-    hccTextureOrient = TEXTURE_ORIENT_LEFT_TO_RIGHT; 
-  }
-   
-  // Vertical collision check
-  while (vccX >= 0 && vccX < worldWidth && vccY >= 0 && vccY < worldHeight && rayAngle != 90 && rayAngle != 270) {
+  // The anchor segments at the viewport borders can hold rays outside of the viewport : their columns are seen as covered by a slice
+  for (rayNumber=firstAnchor << DIVIDE_BY_SURFACE_SEGMENT_SIZE; rayNumber<viewportFirstRay; rayNumber++) {
     
-    // Get block from world map
-    blockXOnMap = vccX >> DIVIDE_BY_BLOCK_SIZE;
-    blockYOnMap = vccY >> DIVIDE_BY_BLOCK_SIZE;
-    vccBlockType = pgm_read_byte(worldMap + blockYOnMap * worldMapWidth + blockXOnMap);
-
-    // If the block is solid (wall, door, ...)
-    if (vccBlockType > 0) {
-      
-      // Save ray length and stop collision check
-      tempLong = vccX - player.x;
-      tempLong = tempLong << MULTIPLY_BY_128;
-      vccRayLength = abs(tempLong / vccCosBy128);
-      break;
-    }
+    sliceTopY[rayNumber] = 0;
+    sliceBottomY[rayNumber] = SCREEN_HEIGHT - 1;
+  }
+  for (rayNumber=viewportStopRay; rayNumber<(lastAnchor << DIVIDE_BY_SURFACE_SEGMENT_SIZE); rayNumber++) {
     
-    // Go to the next block
-    vccX += vccStepX;
-    vccY += vccStepY;
+    sliceTopY[rayNumber] = 0;
+    sliceBottomY[rayNumber] = SCREEN_HEIGHT - 1;
   }
   
-  // Horizontal collision check
-  while (hccX >= 0 && hccX < worldWidth && hccY >= 0 && hccY < worldHeight && rayAngle != 0 && rayAngle != 180) {
+  // Calculate the directions of the anchor rays. 
+  // A floor point seen at the straight distance D by a ray is at : player position + D * (cos(rayAngle), sin(rayAngle)) / cos(rayAngle - player.rot).
+  // With camera plane rays, the direction is the player orientation plus the anchor ray offset along the camera plane : the floor points of a row are
+  // then exactly on a line, evenly spaced.
+  for (uint8_t anchor=firstAnchor; anchor<=lastAnchor; anchor++) {
     
-    // Get block from world map 
-    blockXOnMap = hccX >> DIVIDE_BY_BLOCK_SIZE; 
-    blockYOnMap = hccY >> DIVIDE_BY_BLOCK_SIZE;  
-    hccBlockType = pgm_read_byte(worldMap + blockYOnMap * worldMapWidth + blockXOnMap);
-    
-    // If the block is solid (wall, door, ...)
-    if (hccBlockType > 0) {
+    if (rayMode == RAY_MODE_CAMERA_PLANE) {
       
-      // Save ray length and stop collision check
-      tempLong = hccY - player.y;
-      tempLong = tempLong << MULTIPLY_BY_128; 
-      hccRayLength = abs(tempLong / hccCosBy128);
-      break;
+      anchorOffset = ((anchor << DIVIDE_BY_SURFACE_SEGMENT_SIZE) << MULTIPLY_BY_2) + 1 - (viewportCentreRay << MULTIPLY_BY_2);
+      anchorDirXBy128[anchor] = forwardXBy128 - ((int32_t)forwardYBy128 * anchorOffset) / PROJECTION_DISTANCE;
+      anchorDirYBy128[anchor] = forwardYBy128 + ((int32_t)forwardXBy128 * anchorOffset) / PROJECTION_DISTANCE;
+      continue;
     }
     
-    // Go to the next block
-    hccX += hccStepX;
-    hccY += hccStepY;
+    anchorAngle = (anchor << DIVIDE_BY_SURFACE_SEGMENT_SIZE) - viewportCentreRay;
+    anchorCosBy128 = pgm_read_byte(cosBy128 + abs(anchorAngle));
+    anchorDirXBy128[anchor] = (getCosBy128(player.rot + anchorAngle) << MULTIPLY_BY_128) / anchorCosBy128;
+    anchorDirYBy128[anchor] = (getCosBy128(player.rot + anchorAngle - 90) << MULTIPLY_BY_128) / anchorCosBy128; // Sin(A) = Cos(A - 90)
   }
   
-  // Choose shortest ray between vertical collision check ray and horizontal collision check ray
-  if (hccRayLength < vccRayLength) {
-        
-    rayLength = hccRayLength;
-    blockHitX = hccX;
-    blockHitY = hccY;
-    blockType = hccBlockType;
-    textureSliceX = (blockHitX & (BLOCK_SIZE - 1)) >> DIVIDE_BY_TEXTURE_SCALING_FACTOR; // Equals to "textureSliceX = (blockHitX % BLOCK_SIZE) / TEXTURE_SCALING_FACTOR;"
-    if (hccTextureOrient == TEXTURE_ORIENT_RIGHT_TO_LEFT) {
+  // Render the floor and the ceiling row by row, from the horizon to the viewport borders. A floor row and its mirrored ceiling row show the same 
+  // points. The horizon is at the centre of the viewport, so there are as many floor rows as ceiling rows, or one more.
+  for (uint8_t row=0; row<viewportStopY - horizonY; row++) {
+    
+    rowDistance = pgm_read_word(surfaceRowDistance + row);
+    if (rowDistance > SURFACE_MAX_DISTANCE || (viewDistance && rowDistance > viewDistance)) continue;
+    
+    floorY = horizonY + row;
+    floorPage = buffer + ((floorY >> DIVIDE_BY_8) << MULTIPLY_BY_128);
+    floorBit = 1 << (floorY & 7);     // Equals to 1 << (floorY % 8)
+    if (floorMode != SURFACE_NONE) dirtyPages |= 1 << (floorY >> DIVIDE_BY_8);
+    ceilingRow = ceilingMode != SURFACE_NONE && row < horizonY - viewportY;
+    if (ceilingRow) {
       
-      textureSliceX = (TEXTURE_SIZE - 1) - textureSliceX;
+      ceilingY = horizonY - 1 - row;
+      ceilingPage = buffer + ((ceilingY >> DIVIDE_BY_8) << MULTIPLY_BY_128);
+      ceilingBit = 1 << (ceilingY & 7); // Equals to 1 << (ceilingY % 8)
+      dirtyPages |= 1 << (ceilingY >> DIVIDE_BY_8);
+      minimapRow = minimap && ceilingY < MINIMAP_HEIGHT;
     }
-  }
-  else {
     
-    rayLength = vccRayLength; 
-    blockHitX = vccX;
-    blockHitY = vccY;
-    blockType = vccBlockType;
-
-    textureSliceX = (blockHitY & (BLOCK_SIZE - 1)) >> DIVIDE_BY_TEXTURE_SCALING_FACTOR; // Equals to "textureSliceX = (blockHitY % BLOCK_SIZE) / TEXTURE_SCALING_FACTOR;"
-    if (vccTextureOrient == TEXTURE_ORIENT_RIGHT_TO_LEFT) {
+    // The floor points of the anchor rays are exactly calculated, the points in between are reached with fixed-point steps
+    nextAnchorPointXBy256 = playerXBy256 + (((int32_t)rowDistance * anchorDirXBy128[firstAnchor]) << MULTIPLY_BY_2);
+    nextAnchorPointYBy256 = playerYBy256 + (((int32_t)rowDistance * anchorDirYBy128[firstAnchor]) << MULTIPLY_BY_2);
+    rayNumber = firstAnchor << DIVIDE_BY_SURFACE_SEGMENT_SIZE;
+    
+    for (uint8_t anchor=firstAnchor + 1; anchor<=lastAnchor; anchor++) {
       
-      textureSliceX = (TEXTURE_SIZE - 1) - textureSliceX;
+      pointXBy256 = nextAnchorPointXBy256;
+      pointYBy256 = nextAnchorPointYBy256;
+      nextAnchorPointXBy256 = playerXBy256 + (((int32_t)rowDistance * anchorDirXBy128[anchor]) << MULTIPLY_BY_2);
+      nextAnchorPointYBy256 = playerYBy256 + (((int32_t)rowDistance * anchorDirYBy128[anchor]) << MULTIPLY_BY_2);
+      pointStepXBy256 = (nextAnchorPointXBy256 - pointXBy256) >> DIVIDE_BY_SURFACE_SEGMENT_SIZE;
+      pointStepYBy256 = (nextAnchorPointYBy256 - pointYBy256) >> DIVIDE_BY_SURFACE_SEGMENT_SIZE;
+      
+      for (uint8_t segmentRay=0; segmentRay<SURFACE_SEGMENT_SIZE; segmentRay++) {
+        
+        projectedSliceX = rayNumber << MULTIPLY_BY_2;
+        
+        // Draw the floor point if it is below the slice
+        if (floorMode != SURFACE_NONE && floorY > sliceBottomY[rayNumber] && 
+            getSurfaceTexel(floorMode, floorTexture, floorWidthShift, floorHeightShift, pointXBy256 >> 8, pointYBy256 >> 8)) {
+          
+          floorPage[projectedSliceX] |= floorBit;
+          floorPage[projectedSliceX + 1] |= floorBit;
+          ARCE_PROFILE_COUNT(pixelsWritten, 2);
+        }
+        
+        // Draw the ceiling point if it is above the slice
+        if (ceilingRow && ceilingY < sliceTopY[rayNumber] && !(minimapRow && (uint8_t)(projectedSliceX - minimapX) < MINIMAP_WIDTH) &&
+            getSurfaceTexel(ceilingMode, ceilingTexture, ceilingWidthShift, ceilingHeightShift, pointXBy256 >> 8, pointYBy256 >> 8)) {
+          
+          ceilingPage[projectedSliceX] |= ceilingBit;
+          ceilingPage[projectedSliceX + 1] |= ceilingBit;
+          ARCE_PROFILE_COUNT(pixelsWritten, 2);
+        }
+        
+        pointXBy256 += pointStepXBy256;
+        pointYBy256 += pointStepYBy256;
+        rayNumber++;
+      }
     }
   }
   
-  // If the current view is a 2D view
-  if (view == VIEW_2D_ONERAY || view == VIEW_2D) {
-    
-      // Draw the current ray on the screen
-      if (rayLength) {
+  ARCE_PROFILE_STOP(raster);
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Read the floor or ceiling pixel at a given point of the world. Surfaces textures must use the TEXTURE_FORMAT_ROW_MAJOR format.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+uint8_t ARCE::getSurfaceTexel(uint8_t surfaceMode, const uint8_t *texture, uint8_t textureWidthShift, uint8_t textureHeightShift, uint16_t pointX, uint16_t pointY) {
+  
+  uint8_t texelX = 0; // X position of the texel in the surface texture (texture coordinates).
+  uint8_t texelY = 0; // Y position of the texel in the surface texture (texture coordinates).
+  
+  ARCE_PROFILE_COUNT(texelFetches, 1);
+  
+  // A checkerboard square is a block wide
+  if (surfaceMode == SURFACE_CHECKERBOARD) {
     
-        display.drawLine(player.x / WORLD_TO_SCREEN_SCALING_FACTOR, player.y / WORLD_TO_SCREEN_SCALING_FACTOR, blockHitX / WORLD_TO_SCREEN_SCALING_FACTOR, blockHitY / WORLD_TO_SCREEN_SCALING_FACTOR, 1);
-      }
+    return ((pointX ^ pointY) & BLOCK_SIZE) != 0; // Equals to "((pointX / BLOCK_SIZE) + (pointY / BLOCK_SIZE)) % 2"
   }
+  
+  // A texture covers a block, like the walls textures
+  texelX = (pointX & (BLOCK_SIZE - 1)) >> (MULTIPLY_BY_BLOCK_SIZE - textureWidthShift);
+  texelY = (pointY & (BLOCK_SIZE - 1)) >> (MULTIPLY_BY_BLOCK_SIZE - textureHeightShift);
+  
+  return (ARCE_READ_BYTE(texture + TEXTURE_DESCRIPTOR_SIZE + (((texelY << textureWidthShift) + texelX) >> DIVIDE_BY_8)) & (128 >> (texelX & 7))) != 0;
+}
 
-  // If the current view is a 3D view
-  else {
-    
-    // Apply a "Fishbowl effect correction" on the ray length (correct distance = distorted distance * cos(angle))
-    tempLong = rayLength;
-    tempLong = tempLong * pgm_read_byte(cosBy128 + abs(rayNumber - HALF_FOV));
-    rayLength = tempLong >> DIVIDE_BY_128;
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Get the signed cosinus of any angle, multiplied by 128.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+int16_t ARCE::getCosBy128(int16_t angle) {
+  
+  // Angle should remain between 0 and 360 degrees
+  angle %= 360;
+  if (angle < 0) angle += 360;
+  
+  if (angle <= 90) return pgm_read_byte(cosBy128 + angle);
+  else if (angle <= 180) return -pgm_read_byte(cosBy128 + (180 - angle));
+  else if (angle < 270) return -pgm_read_byte(cosBy128 + (angle - 180));
+  else return pgm_read_byte(cosBy128 + (360 - angle));
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Find the first block between the origin and the target of a query. Unlike castRay(), this function does not use the player and does not draw 
+// anything : it can be used by the game logic (line of sight, hitscan weapons, sound propagation, etc...).
+// The segment goes through the world map cell by cell and stops at the target cell, at the first block or at the world border. The block of the 
+// origin cell is ignored. The results are saved in the query. Returns true if a block was hit.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+bool ARCE::castQuery(ARCERayQuery *query) {
+  
+  setQueryOrigin(query->originX, query->originY);
+  return traceQuery(query);
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Set up the origin of the next queries answered by traceQuery() : the origin cell and its position in the world map, so the cells crossed by the 
+// queries are read without any multiplication.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+void ARCE::setQueryOrigin(int16_t originX, int16_t originY) {
+  
+  queryOriginX = originX;
+  queryOriginY = originY;
+  queryCellX = originX >> DIVIDE_BY_BLOCK_SIZE;
+  queryCellY = originY >> DIVIDE_BY_BLOCK_SIZE;
+  queryMapPos = queryCellY * worldMapWidth + queryCellX;
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Find the first block between the origin set up with setQueryOrigin() and the target of a query (see castQuery()). Returns true if a block was hit.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+bool ARCE::traceQuery(ARCERayQuery *query) {
+  
+  int16_t deltaX = query->targetX - queryOriginX; // X length of the segment (world coordinates).
+  int16_t deltaY = query->targetY - queryOriginY; // Y length of the segment (world coordinates).
+  uint16_t absDeltaX = abs(deltaX);        // Absolute X length of the segment (world coordinates).
+  uint16_t absDeltaY = abs(deltaY);        // Absolute Y length of the segment (world coordinates).
+  int8_t cellStepX = (deltaX < 0) ? -1 : 1; // Step to make along the X axis in the world map (world map coordinates).
+  int8_t cellStepY = (deltaY < 0) ? -1 : 1; // Step to make along the Y axis in the world map (world map coordinates).
+  int16_t mapStepY = (deltaY < 0) ? -worldMapWidth : worldMapWidth; // Step of the world map position for each cellStepY.
+  int16_t cellX = queryCellX;              // X position of the current cell (world map coordinates).
+  int16_t cellY = queryCellY;              // Y position of the current cell (world map coordinates).
+  int16_t mapPos = queryMapPos;            // Position of the current cell in the world map.
+  int16_t targetCellX = query->targetX >> DIVIDE_BY_BLOCK_SIZE; // X position of the target cell (world map coordinates).
+  int16_t targetCellY = query->targetY >> DIVIDE_BY_BLOCK_SIZE; // Y position of the target cell (world map coordinates).
+  uint16_t nextLineX = 0;                  // X distance between the origin and the next vertical grid line (world coordinates).
+  uint16_t nextLineY = 0;                  // Y distance between the origin and the next horizontal grid line (world coordinates).
+  int32_t crossX = 0;                      // nextLineX * absDeltaY : the segment meets the next vertical line first when crossX <= crossY.
+  int32_t crossY = 0;                      // nextLineY * absDeltaX.
+  int32_t crossStepX = (int32_t)absDeltaY << MULTIPLY_BY_BLOCK_SIZE; // Step of crossX for each vertical grid line.
+  int32_t crossStepY = (int32_t)absDeltaX << MULTIPLY_BY_BLOCK_SIZE; // Step of crossY for each horizontal grid line.
+  bool verticalLine = false;               // Tells if the last grid line crossed is vertical.
+  uint8_t blockType = 0;                   // Type of the current block.
+  uint32_t distanceSquare = 0;             // Square of the distance between the origin and the point hit (world coordinates).
+  int32_t tempLong;                        // Variable used for 24 or 32 bits operations.
+  
+  query->hit = false;
+  
+  // Distances to the first grid lines
+  if (deltaX < 0) nextLineX = queryOriginX - (cellX << MULTIPLY_BY_BLOCK_SIZE);
+  else nextLineX = ((cellX + 1) << MULTIPLY_BY_BLOCK_SIZE) - queryOriginX;
+  if (deltaY < 0) nextLineY = queryOriginY - (cellY << MULTIPLY_BY_BLOCK_SIZE);
+  else nextLineY = ((cellY + 1) << MULTIPLY_BY_BLOCK_SIZE) - queryOriginY;
+  crossX = (int32_t)nextLineX * absDeltaY;
+  crossY = (int32_t)nextLineY * absDeltaX;
+  
+  // Go through the cells crossed by the segment. Comparing the cross products gives the next grid line without any division, and the world map 
+  // position follows the cell.
+  while (cellX != targetCellX || cellY != targetCellY) {
     
-    // -----------------------------------------
-    // Render 3D view on the screen (projection)
-    // -----------------------------------------
-   
-    // Calculate the projected slice height
-    //
-    //                                                Slice height (word coordinates) * Distance to projection plane (screen coordinates)
-    // Projected slice height (screen coordinates)  = ----------------------------------------------------------------------------------- 
-    //                                                                   Distance to the slice (word coordinates)
-    //
-    // Slice height = BLOCK_SIZE = 64
-    //
-    // Field of view = FOV = 64
-    // FOV / 2 = HALF_FOV = 32
-    // Screen width = SCREEN_WIDTH = 128
-    // Screen width / 2 = HALF_SCREEN_WIDTH = 64
-    // HALF_SCREEN_WIDTH / tan(HALF_FOV) = 64 / tan(32) = 102 = Distance to projection plane
-    //
-    // Distance to the slice = rayLength
-    //
-    //                           BLOCK_SIZE * 102     64 * 102        6528        PROJECTION_K
-    // Projected Slice Height = ------------------ = ----------- = ----------- = --------------
-    //                               rayLength        rayLength     rayLength      rayLength
-    //
-    if (rayLength == 0) {
-      
-      projectedSliceHeight = PROJECTION_K;
+    if (absDeltaX && (!absDeltaY || crossX <= crossY)) {
+      
+      cellX += cellStepX;
+      mapPos += cellStepX;
+      nextLineX += BLOCK_SIZE;
+      crossX += crossStepX;
+      verticalLine = true;
     }
     else {
-       
-       projectedSliceHeight = PROJECTION_K / rayLength;
+      
+      cellY += cellStepY;
+      mapPos += mapStepY;
+      nextLineY += BLOCK_SIZE;
+      crossY += crossStepY;
+      verticalLine = false;
     }
     
-    // Calculate the X position of the projected slice on the screen
-    projectedSliceX = rayNumber << MULTIPLY_BY_2;
+    if (cellX < 0 || cellX >= worldMapWidth || cellY < 0 || cellY >= worldMapHeight) break;
     
-    // Calculate the Y position of the projected slice on the screen and initialize projected slice render process
-    projectedSliceY = HALF_SCREEN_HEIGHT - (projectedSliceHeight >> DIVIDE_BY_2);
-    if (projectedSliceY < 0) {
+    blockType = ARCE_READ_BYTE(worldMap + mapPos);
+    ARCE_PROFILE_COUNT(mapReads, 1);
+    
+    // If the block is solid (wall, door, ...), calculate the point hit on its face
+    if (blockType > 0) {
       
-      projectedSliceRenderStartY = 0 - projectedSliceY;
-      projectedSliceRenderStopY = projectedSliceRenderStartY + SCREEN_HEIGHT - 1;
-    }
-    else {
+      query->hit = true;
+      query->blockXOnMap = cellX;
+      query->blockYOnMap = cellY;
+      query->blockType = blockType;
+      
+      if (verticalLine) {
+        
+        tempLong = nextLineX - BLOCK_SIZE;
+        query->hitX = queryOriginX + cellStepX * (int16_t)tempLong;
+        query->hitY = queryOriginY + (tempLong * deltaY) / absDeltaX;
+      }
+      else {
+        
+        tempLong = nextLineY - BLOCK_SIZE;
+        query->hitX = queryOriginX + (tempLong * deltaX) / absDeltaY;
+        query->hitY = queryOriginY + cellStepY * (int16_t)tempLong;
+      }
       
-      projectedSliceRenderStartY = 0;
-      projectedSliceRenderStopY = projectedSliceHeight - 1;
+      tempLong = query->hitX - queryOriginX;
+      distanceSquare = tempLong * tempLong;
+      tempLong = query->hitY - queryOriginY;
+      query->distance = getSquareRoot(distanceSquare + tempLong * tempLong);
+      break;
     }
+  }
+  
+  return query->hit;
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Find the first block in a given direction (degrees) from the origin of a query, up to a given distance. A zero distance goes through the whole world.
+// The target of the query is set to the farthest point of the ray. The origin must be inside the world.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+bool ARCE::castQuery(ARCERayQuery *query, int16_t angle, uint16_t maxDistance) {
+  
+  int32_t deltaX = 0;    // X length of the segment (world coordinates).
+  int32_t deltaY = 0;    // Y length of the segment (world coordinates).
+  int32_t longestDelta;  // Longest of the X and Y lengths of the segment (world coordinates).
+  
+  if (maxDistance == 0) maxDistance = worldWidth + worldHeight;
+  
+  deltaX = ((int32_t)maxDistance * getCosBy128(angle)) >> DIVIDE_BY_128;
+  deltaY = ((int32_t)maxDistance * getCosBy128(angle - 90)) >> DIVIDE_BY_128; // Sin(A) = Cos(A - 90)
+  
+  // A long segment is shortened along its direction : QUERY_MAX_DELTA still reaches the world border, and the target stays in the int16 range
+  longestDelta = abs(deltaX);
+  if (abs(deltaY) > longestDelta) longestDelta = abs(deltaY);
+  if (longestDelta > QUERY_MAX_DELTA) {
     
-    // If the view is the VIEW_3D_SOLID view
-    if (view == VIEW_3D_SOLID) {
+    deltaX = (deltaX * QUERY_MAX_DELTA) / longestDelta;
+    deltaY = (deltaY * QUERY_MAX_DELTA) / longestDelta;
+  }
+  
+  query->targetX = query->originX + deltaX;
+  query->targetY = query->originY + deltaY;
+  
+  return castQuery(query);
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Answer several queries (enemies lines of sight, etc...). Consecutive queries with the same origin share its setup (origin cell and world map 
+// position). A line of sight is the same in both directions (but for segments going exactly through a block corner) : the lines of sight of all the
+// enemies can be written from the player, one after the other. Each query stops at its target, so near targets are cheaper than full rays. 
+// Returns the number of queries with a clear line of sight.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+uint8_t ARCE::castQueries(ARCERayQuery *queries, uint8_t queryCount) {
+  
+  uint8_t clearCount = 0; // Number of queries with a clear line of sight.
+  
+  for (uint8_t query=0; query<queryCount; query++) {
+    
+    // The origin is only set up again when it changes
+    if (query == 0 || queries[query].originX != queryOriginX || queries[query].originY != queryOriginY) {
       
-      // Render a solid slice
-      display.drawFastVLine(projectedSliceX, projectedSliceY + projectedSliceRenderStartY, projectedSliceHeight, 1);
-      display.drawFastVLine(projectedSliceX + 1, projectedSliceY + projectedSliceRenderStartY, projectedSliceHeight, 1);
+      setQueryOrigin(queries[query].originX, queries[query].originY);
     }
+    if (!traceQuery(queries + query)) clearCount++;
+  }
+  
+  return clearCount;
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Move all the entities of a given store by one step, in a single pass. Each axis is moved separately : when the entity circle (approximated by its 
+// bounding box) would enter a block, the entity is stopped against the block face and keeps moving along the other axis, so it slides along walls.
+// The ENTITY_BLOCKED_X and ENTITY_BLOCKED_Y flags tell the game which moves were stopped.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+void ARCE::updateEntities(ARCEEntities *entities) {
+  
+  int16_t newX = 0;      // New X position of the entity (world coordinates).
+  int16_t newY = 0;      // New Y position of the entity (world coordinates).
+  int16_t edge = 0;      // Position of the entity bounding box edge in the move direction (world coordinates).
+  uint8_t radius = 0;    // Collision radius of the entity (world coordinates).
+  int8_t moveX = 0;      // X move of the entity for the current sub-step (world coordinates).
+  int8_t moveY = 0;      // Y move of the entity for the current sub-step (world coordinates).
+  uint8_t subSteps = 0;  // Number of sub-steps of the entity move.
+  
+  for (ARCEEntityIndex entity=0; entity<entities->count; entity++) {
     
-    // If the view is the VIEW_3D_TEXTURED view
-    else {
+    if (!(entities->flags[entity] & ENTITY_ACTIVE)) continue;
+    
+    entities->flags[entity] &= ~(ENTITY_BLOCKED_X | ENTITY_BLOCKED_Y);
+    if (entities->velocityX[entity] == 0 && entities->velocityY[entity] == 0) continue;
+    
+    newX = entities->x[entity];
+    newY = entities->y[entity];
+    radius = entities->radius[entity];
+    
+    // The collisions are only tested at the destination, so a move of BLOCK_SIZE or more is split in two sub-steps : the bounding box edge never 
+    // jumps over a whole block
+    subSteps = (abs(entities->velocityX[entity]) >= BLOCK_SIZE || abs(entities->velocityY[entity]) >= BLOCK_SIZE) ? 2 : 1;
+    
+    for (uint8_t subStep=0; subStep<subSteps; subStep++) {
+      
+      // The last sub-step also makes the rest of the division
+      moveX = entities->velocityX[entity] / subSteps;
+      moveY = entities->velocityY[entity] / subSteps;
+      if (subStep == subSteps - 1) {
+        
+        moveX = entities->velocityX[entity] - moveX * subStep;
+        moveY = entities->velocityY[entity] - moveY * subStep;
+      }
       
-      // -----------------------
-      // Render a textured slice
-      // -----------------------
-      
-      // Calculate texture slice render step
-      //
-      //                                  Texture height 
-      // Texture slice render step = ------------------------ 
-      //                              Projected slice height
-      //
-      //                                  Texture height * k             TEXTURE_SIZE * K                 32 * 128                TEXTURE_SIZE_BY_K
-      // Texture slice render step = ---------------------------- = -------------------------- = -------------------------- = --------------------------
-      //                              Projected slice height * k     projectedSliceHeight * K     projectedSliceHeight * K     projectedSliceHeight * k
-      //
-      //                                   TEXTURE_SIZE_BY_K
-      // Texture slice render step * k = ----------------------
-      //                                  projectedSliceHeight
-      //
-      textureSliceRenderStepByK = TEXTURE_SIZE_BY_K / projectedSliceHeight;
-      
-      // Render the textured slice on the screen
-      for (uint8_t projectedSliceRenderY = projectedSliceRenderStartY; projectedSliceRenderY <= projectedSliceRenderStopY; projectedSliceRenderY++) {
+      // Move along the X axis
+      if (moveX != 0 && !(entities->flags[entity] & ENTITY_BLOCKED_X)) {
+        
+        newX += moveX;
+        edge = (moveX > 0) ? newX + radius : newX - radius;
+        if (isSolid(edge, newY - radius) || isSolid(edge, newY + radius)) {
           
-        // Get pixel from the texture (get texel)
-        texelY = (projectedSliceRenderY * textureSliceRenderStepByK) >> DIVIDE_BY_K;
-        texelPosInTexture = texelY * TEXTURE_SIZE + textureSliceX;
-        texelBytePosInTexture = texelPosInTexture >> DIVIDE_BY_8;
-        texelByte = pgm_read_byte(texturesArray[blockType - 1] + texelBytePosInTexture); 
-        texelPosInTexelByte = texelPosInTexture & 7; // Equals to texelPosInTexture % 8
-        texelByteMask = 128 >> texelPosInTexelByte;
-        texelByteReadWithMask = texelByte & texelByteMask;
-        texel = texelByteReadWithMask >> (7 - texelPosInTexelByte);
+          entities->flags[entity] |= ENTITY_BLOCKED_X;
+          if (moveX > 0) newX = ((edge >> DIVIDE_BY_BLOCK_SIZE) << MULTIPLY_BY_BLOCK_SIZE) - radius - 1;
+          else newX = (((edge >> DIVIDE_BY_BLOCK_SIZE) + 1) << MULTIPLY_BY_BLOCK_SIZE) + radius;
+        }
+      }
+      
+      // Move along the Y axis
+      if (moveY != 0 && !(entities->flags[entity] & ENTITY_BLOCKED_Y)) {
         
-        // Draw the texel
-        projectedTexelY = projectedSliceY + projectedSliceRenderY;
-        display.drawPixel(projectedSliceX, projectedTexelY, texel);
-        display.drawPixel(projectedSliceX + 1, projectedTexelY, texel);          
-      } 
+        newY += moveY;
+        edge = (moveY > 0) ? newY + radius : newY - radius;
+        if (isSolid(newX - radius, edge) || isSolid(newX + radius, edge)) {
+          
+          entities->flags[entity] |= ENTITY_BLOCKED_Y;
+          if (moveY > 0) newY = ((edge >> DIVIDE_BY_BLOCK_SIZE) << MULTIPLY_BY_BLOCK_SIZE) - radius - 1;
+          else newY = (((edge >> DIVIDE_BY_BLOCK_SIZE) + 1) << MULTIPLY_BY_BLOCK_SIZE) + radius;
+        }
+      }
+    }
+    
+    entities->setPosition(entity, newX, newY);
+  }
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Tells if a given point of the world is inside a block or outside the world.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+bool ARCE::isSolid(int16_t x, int16_t y) {
+  
+  if (x < 0 || x >= (int16_t)worldWidth || y < 0 || y >= (int16_t)worldHeight) return true;
+  
+  ARCE_PROFILE_COUNT(mapReads, 1);
+  
+  return ARCE_READ_BYTE(worldMap + (y >> DIVIDE_BY_BLOCK_SIZE) * worldMapWidth + (x >> DIVIDE_BY_BLOCK_SIZE)) > 0;
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Get the integer square root of a value (bit by bit method).
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+uint16_t ARCE::getSquareRoot(uint32_t value) {
+  
+  uint32_t root = 0;                 // Square root being built.
+  uint32_t bit = (uint32_t)1 << 30;  // Current bit of the square root, multiplied by itself.
+  
+  while (bit > value) bit >>= 2;
+  
+  while (bit) {
+    
+    if (value >= root + bit) {
+      
+      value -= root + bit;
+      root = (root >> 1) + bit;
     }
+    else root >>= 1;
+    bit >>= 2;
   }
+  
+  return root;
 }
 
 // ------------------------------------------------------------------------------------------------------------------------------------------------------
-// Load a given world map in the engine.
+// Load a given world map in the engine, and build the minimap and the map cache of the 2D views.
 // ------------------------------------------------------------------------------------------------------------------------------------------------------
 void ARCE::loadWorldMap(const uint8_t *worldMap, uint8_t worldMapWidth, uint8_t worldMapHeight) {
   
   this->worldMap = worldMap;
+  levelPack = 0;
+  lightMap = 0;
   this->worldMapWidth = worldMapWidth;
   this->worldMapHeight = worldMapHeight;
   worldWidth = worldMapWidth * BLOCK_SIZE; 
   worldHeight = worldMapHeight * BLOCK_SIZE;
+  enclosedWorldMap = true;
+  
+  // Build the minimap : the smallest downsampling which fits the world map in the minimap, and a minimap pixel is set when one of its blocks is solid.
+  // The world map is enclosed when all the blocks of its border are solid.
+  minimapShift = 0;
+  while (((worldMapWidth - 1) >> minimapShift) >= MINIMAP_WIDTH || ((worldMapHeight - 1) >> minimapShift) >= MINIMAP_HEIGHT) minimapShift++;
+  memset(minimapBitmap, 0, sizeof(minimapBitmap));
+  for (uint8_t blockY=0; blockY<worldMapHeight; blockY++) {
+    
+    for (uint8_t blockX=0; blockX<worldMapWidth; blockX++) {
+      
+      if (ARCE_READ_BYTE(worldMap + blockY * worldMapWidth + blockX) > 0) {
+        
+        minimapBitmap[((blockY >> minimapShift) >> DIVIDE_BY_8) * MINIMAP_WIDTH + (blockX >> minimapShift)] |= 1 << ((blockY >> minimapShift) & 7);
+      }
+      else if (blockX == 0 || blockY == 0 || blockX == worldMapWidth - 1 || blockY == worldMapHeight - 1) {
+        
+        enclosedWorldMap = false;
+      }
+    }
+  }
+  
+  // Build the map cache used by the 2D views, if the world map fits in it
+  mapCacheRowSize = (worldMapWidth + 7) >> DIVIDE_BY_8;
+  if (mapCacheRowSize * worldMapHeight > ARCE_MAP_CACHE_SIZE) {
+    
+    mapCacheRowSize = 0;
+    return;
+  }
+  memset(mapCache, 0, mapCacheRowSize * worldMapHeight);
+  for (uint8_t blockY=0; blockY<worldMapHeight; blockY++) {
+    
+    for (uint8_t blockX=0; blockX<worldMapWidth; blockX++) {
+      
+      if (ARCE_READ_BYTE(worldMap + blockY * worldMapWidth + blockX) > 0) mapCache[blockY * mapCacheRowSize + (blockX >> DIVIDE_BY_8)] |= 1 << (blockX & 7);
+    }
+  }
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Load the world map, the textures, the block heights and the light map of a level pack (see the level pack section in ARCE.h). Nothing is copied : the engine reads
+// the level pack in place, so loading a level only costs the header reads and the map caches. Returns false if the pack is not valid.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+bool ARCE::loadLevelPack(const uint8_t *levelPack) {
+  
+  uint16_t texturesOffset = 0; // Offset of the textures table in the level pack.
+  uint16_t heightsOffset = 0;  // Offset of the block heights in the level pack (0 = no block heights).
+  uint16_t lightMapOffset = 0; // Offset of the light map in the level pack (0 = no light map).
+  uint8_t textureCount = 0;    // Number of textures in the level pack.
+  
+  // Check the header
+  if (ARCE_READ_BYTE(levelPack) != 'A' || ARCE_READ_BYTE(levelPack + 1) != 'R' || ARCE_READ_BYTE(levelPack + 2) != 'C' || ARCE_READ_BYTE(levelPack + 3) != 'L' || 
+      ARCE_READ_BYTE(levelPack + 4) != LEVEL_PACK_VERSION || ARCE_READ_BYTE(levelPack + 5) != LEVEL_MAP_RAW) {
+    
+    return false;
+  }
+  
+  // The world map and the textures are read in place
+  loadWorldMap(levelPack + ARCE_READ_WORD(levelPack + 8), ARCE_READ_BYTE(levelPack + 6), ARCE_READ_BYTE(levelPack + 7));
+  this->levelPack = levelPack;
+  textureCount = ARCE_READ_BYTE(levelPack + 10);
+  texturesOffset = ARCE_READ_WORD(levelPack + 12);
+  for (uint8_t texture=0; texture<textureCount; texture++) {
+    
+    texturesArray[texture] = levelPack + ARCE_READ_WORD(levelPack + texturesOffset + (texture << 1));
+  }
+  heightsOffset = ARCE_READ_WORD(levelPack + 16);
+  loadBlockHeights(heightsOffset ? levelPack + heightsOffset : 0, textureCount);
+  lightMapOffset = ARCE_READ_WORD(levelPack + 20);
+  loadLightMap(lightMapOffset ? levelPack + lightMapOffset : 0);
+  
+  return true;
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Move the player to a given spawn point of the loaded level pack. Returns false if there is no such spawn point.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+bool ARCE::spawnPlayer(uint8_t spawnPoint) {
+  
+  const uint8_t *spawn; // Spawn point in the level pack.
+  
+  if (!levelPack || spawnPoint >= ARCE_READ_BYTE(levelPack + 11)) return false;
+  
+  spawn = levelPack + ARCE_READ_WORD(levelPack + 14) + spawnPoint * 6;
+  player.x = ARCE_READ_WORD(spawn);
+  player.y = ARCE_READ_WORD(spawn + 2);
+  player.rot = ARCE_READ_WORD(spawn + 4);
+  return true;
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Read a level pack from an external storage into a RAM buffer, LEVEL_PACK_CHUNK_SIZE bytes at a time, and load it. The engine must be compiled with 
+// ARCE_ASSETS_IN_RAM in order to read the level pack from the RAM. Returns the level pack, or 0 if it can't be read or does not fit in the buffer.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+const uint8_t *ARCE::streamLevelPack(ARCELevelPackReader reader, uint8_t *levelBuffer, uint16_t levelBufferSize) {
+  
+  uint16_t levelPackSize = 0; // Size of the level pack (bytes).
+  uint16_t chunkSize = 0;     // Size of the current chunk (bytes).
+  
+  // Read the header first, in order to get the level pack size
+  if (levelBufferSize < LEVEL_PACK_HEADER_SIZE || reader(0, levelBuffer, LEVEL_PACK_HEADER_SIZE) != LEVEL_PACK_HEADER_SIZE) return 0;
+  levelPackSize = levelBuffer[18] | (levelBuffer[19] << 8);
+  if (levelPackSize < LEVEL_PACK_HEADER_SIZE || levelPackSize > levelBufferSize) return 0;
+  
+  // Read the rest of the level pack
+  for (uint16_t offset=LEVEL_PACK_HEADER_SIZE; offset<levelPackSize; offset+=chunkSize) {
+    
+    chunkSize = levelPackSize - offset;
+    if (chunkSize > LEVEL_PACK_CHUNK_SIZE) chunkSize = LEVEL_PACK_CHUNK_SIZE;
+    if (reader(offset, levelBuffer + offset, chunkSize) != chunkSize) return 0;
+  }
+  
+  if (!loadLevelPack(levelBuffer)) return 0;
+  return levelBuffer;
+}
+
+#ifdef ARCE_HOST
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Map a level pack file in memory (host builds). The file is mapped read only and never copied, so the cost does not depend on the pack size : the 
+// pages are read when the engine reads them. The mapping lasts until the program ends. Returns 0 if the file can't be mapped.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+const uint8_t *ARCE::mapLevelPack(const char *path) {
+  
+  int file = 0;           // Level pack file descriptor.
+  struct stat fileStatus; // Level pack file status (size).
+  void *levelPack;        // Level pack mapped in memory.
+  
+  file = open(path, O_RDONLY);
+  if (file < 0) return 0;
+  if (fstat(file, &fileStatus) != 0 || fileStatus.st_size < LEVEL_PACK_HEADER_SIZE) {
+    
+    close(file);
+    return 0;
+  }
+  levelPack = mmap(0, fileStatus.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+  close(file);
+  if (levelPack == MAP_FAILED) return 0;
+  
+  return (const uint8_t *)levelPack;
+}
+#endif
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Load the baked light of each block face of the world map (lightMap[y * worldMapWidth + x], in PROGMEM, written with LIGHT_MAP_CELL()). Each byte 
+// holds the light level of the 4 faces of a block, from 0 (lit) to 3 (darkest), added to the shade band of the slices with the SHADING_LIGHT_MAP 
+// shading. The light is computed offline from the light sources of the level (see ARCEAssets), so the renderer only reads one byte for each column.
+// Must be called after loadWorldMap() : a new world map unloads the light map.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+void ARCE::loadLightMap(const uint8_t *lightMap) {
+  
+  this->lightMap = lightMap;
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Load the height of each block type, in world coordinates (BLOCK_SIZE for a full height wall, lower for low walls and steps, up to 255 for towers).
+// blockHeights[t - 1] is the height of the block type t, in PROGMEM. With block heights, a ray goes on behind the blocks which do not cover its whole
+// column, and the blocks behind are rendered above them. A null blockHeights makes all the blocks BLOCK_SIZE high again.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+void ARCE::loadBlockHeights(const uint8_t *blockHeights, uint8_t blockTypeCount) {
+  
+  this->blockHeights = blockHeights;
+  maxBlockHeight = BLOCK_SIZE;
+  if (!blockHeights) return;
+  
+  maxBlockHeight = 0;
+  for (uint8_t blockType=0; blockType<blockTypeCount; blockType++) {
+    
+    if (ARCE_READ_BYTE(blockHeights + blockType) > maxBlockHeight) maxBlockHeight = ARCE_READ_BYTE(blockHeights + blockType);
+  }
 }
 
 // ------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -566,7 +2711,7 @@ uint8_t ARCE::getTexel (uint8_t texelX, uint8_t texelY, const uint8_t *texture,
 
   texelPosInTexture = texelY * textureWidth + texelX;
   texelBytePosInTexture = texelPosInTexture >> DIVIDE_BY_8;
-  texelByte = pgm_read_byte(texture + texelBytePosInTexture); 
+  texelByte = ARCE_READ_BYTE(texture + texelBytePosInTexture); 
   texelPosInTexelByte = texelPosInTexture & 7; // equals to texelPosInTexture % 8
   texelByteMask = 128 >> texelPosInTexelByte;
   texelByteReadWithMask = texelByte & texelByteMask;
@@ -575,3 +2720,11 @@ uint8_t ARCE::getTexel (uint8_t texelX, uint8_t texelY, const uint8_t *texture,
   return texel;
 }
 
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Get the size of a texture level (bytes) from its width and height expressed as powers of 2.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+uint16_t ARCE::getTextureLevelSize(uint8_t widthShift, uint8_t heightShift) {
+  
+  return ((1 << (widthShift + heightShift)) + 7) >> DIVIDE_BY_8;
+}
+
@@ -51,15 +51,37 @@
 #ifndef ARCE_H
 #define ARCE_H
 
+#ifdef ARCE_HOST
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#else
 #include <SPI.h>
+#include <util/crc16.h>
 #include <EEPROM.h>
 #include "Arduboy.h"
+#endif
+
+// ARCE host builds. Define ARCE_HOST with a compiler flag when the engine is built for a computer (tools, tests) : the Arduino and Arduboy libraries
+// are not used, the flash memory reads become plain reads, and ARCE::mapLevelPack() is available to map a level pack file in memory. There is no 
+// display : the engine renders into ARCE.screenBuffer (or another render target), displayFrame() writes ARCE.displayMemory like the display controller
+// would, and the Serial printing functions are left out.
+#ifdef ARCE_HOST
+#define PROGMEM                                                // The engine tables are plain constant arrays.
+#define pgm_read_byte(address) (*(const uint8_t *)(address))  // Read a byte of a table.
+#define pgm_read_word(address) ((uint16_t)pgm_read_byte(address) | ((uint16_t)pgm_read_byte((const uint8_t *)(address) + 1) << 8)) // Read a word of a table (little endian, as on the device).
+uint32_t micros();                                             // Time since the program start (microseconds), as the Arduino function.
+uint16_t _crc_ccitt_update(uint16_t crc, uint8_t data);        // CRC-CCITT update, as the avr-libc function.
+#endif
 
 // Arduboy device constants
 #define SCREEN_WIDTH 128      // Arduboy screen width.     
 #define SCREEN_HEIGHT 64      // Arduboy screen height. 
 #define HALF_SCREEN_WIDTH 64  // Half Arduboy screen width. 
 #define HALF_SCREEN_HEIGHT 32 // Half Arduboy screen height.
+#define SCREEN_BUFFER_SIZE 1024 // Arduboy screen buffer size (bytes).
+#define OLED_SET_COLUMN_ADDRESS 0x21 // Display controller command : set the first and last columns of the display window.
+#define OLED_SET_PAGE_ADDRESS 0x22   // Display controller command : set the first and last pages of the display window.
 #define KEY_UP 8              // Constant for the "UP" button. Can be used with the Arduino digitalRead function.
 #define KEY_DOWN 10           // Constant for the "DOWN" button. Can be used with the Arduino digitalRead function.
 #define KEY_LEFT 9            // Constant for the "LEFT" button. Can be used with the Arduino digitalRead function.
@@ -78,8 +100,57 @@
 #define VIEW_2D 1                      // 2D view with all rays. Can be used with the ARCE.view variable. 
 #define VIEW_3D_SOLID 2                // 3D view without textures. Can be used with the ARCE.view variable. 
 #define VIEW_3D_TEXTURED 3             // 3D view with textures. Can be used with the ARCE.view variable. 
+#define MAP_ZOOM_1 0                   // 2D views zoom : 1 pixel per block. Can be used with the ARCE.mapZoom variable.
+#define MAP_ZOOM_2 1                   // 2D views zoom : 2 x 2 pixels per block. Can be used with the ARCE.mapZoom variable.
+#define MAP_ZOOM_4 2                   // 2D views zoom : 4 x 4 pixels per block. Can be used with the ARCE.mapZoom variable.
+#define MAP_ZOOM_8 3                   // 2D views zoom : 8 x 8 pixels per block. Can be used with the ARCE.mapZoom variable.
 #define TEXTURE_ORIENT_LEFT_TO_RIGHT 0 // Texture orientation. The texture have to be render from left to right. 
 #define TEXTURE_ORIENT_RIGHT_TO_LEFT 1 // Texture orientation. The texture have to be render from right to left.
+#define TEXTURE_FORMAT_ROW_MAJOR 0     // Texture packing format : texels are stored row by row, 8 texels per byte (most significant bit first).
+#define TEXTURE_FORMAT_COLUMN_MAJOR 1  // Texture packing format : texels are stored column by column, 8 texels per byte (most significant bit first).
+#define TEXTURE_FORMAT_RLE 2           // Texture packing format : texels are stored column by column as runs of texels of the same value (run-length encoding).
+#define TEXTURE_RLE_VALUE 128          // Bit of a run byte giving the value of the texels of the run (RLE textures).
+#define TEXTURE_RLE_LENGTH_MASK 127    // Mask used to read the number of texels of a run from a run byte (RLE textures).
+#define TEXTURE_SIZE_8 3               // Texture width or height of 8 texels (power of 2). Can be used in a texture descriptor.
+#define TEXTURE_SIZE_16 4              // Texture width or height of 16 texels (power of 2). Can be used in a texture descriptor.
+#define TEXTURE_SIZE_32 5              // Texture width or height of 32 texels (power of 2). Can be used in a texture descriptor.
+#define TEXTURE_SIZE_64 6              // Texture width or height of 64 texels (power of 2). Can be used in a texture descriptor.
+#define TEXTURE_MASKED 128             // Texture flag : the texture has a mask (0 = transparent texel). Can be combined with the levels of detail count in a texture descriptor.
+#define TEXTURE_LOD_COUNT_MASK 15      // Mask used to read the levels of detail count from the texture descriptor flags.
+#define TEXTURE_DESCRIPTOR_SIZE 4      // Size of a texture descriptor (bytes).
+#define TEXTURE_RLE_OFFSET(offset) ((offset) & 0xFF), ((offset) >> 8) // Write a column offset in an RLE texture array (16 bits, low byte first).
+#define LEVEL_PACK_MAGIC 'A', 'R', 'C', 'L' // First bytes of a level pack.
+#define LEVEL_PACK_WORD(value) ((value) & 0xFF), ((value) >> 8) // Write a 16 bits value in a level pack array (low byte first).
+#define LEVEL_MAP_RAW 0                // Level pack world map encoding : one byte for each block, row by row.
+#define SURFACE_NONE 0                 // Floor or ceiling is not rendered (black). Can be used with the ARCE.floorMode and ARCE.ceilingMode variables.
+#define SURFACE_CHECKERBOARD 1         // Floor or ceiling is rendered with a checkerboard. Can be used with the ARCE.floorMode and ARCE.ceilingMode variables.
+#define SURFACE_TEXTURED 2             // Floor or ceiling is rendered with a texture. Can be used with the ARCE.floorMode and ARCE.ceilingMode variables.
+#define SHADING_NONE 0                 // Slices are not shaded. Can be used with the ARCE.shadingMode variable.
+#define SHADING_DISTANCE 1             // Slices are dithered according to their distance. Can be combined with the other shadings and used with the ARCE.shadingMode variable.
+#define SHADING_SIDE 2                 // Slices of horizontal collisions are one shade darker. Can be combined with the other shadings and used with the ARCE.shadingMode variable.
+#define SHADING_LIGHT_MAP 4            // Slices are darkened by the baked light of the block face (see ARCE::loadLightMap()). Can be combined with the other shadings.
+#define SHADING_FOG 8                  // Slices fade out in the fog band before the ARCE.viewDistance cutoff. Can be combined with the other shadings.
+#define LIGHT_FACE_NORTH 0             // Light map face : face of a block looking at the top of the world map (lower Y).
+#define LIGHT_FACE_EAST 1              // Light map face : face of a block looking at the right of the world map (higher X).
+#define LIGHT_FACE_SOUTH 2             // Light map face : face of a block looking at the bottom of the world map (higher Y).
+#define LIGHT_FACE_WEST 3              // Light map face : face of a block looking at the left of the world map (lower X).
+#define LIGHT_LEVEL_MASK 3             // Mask used to read the light level of a face from a light map byte (0 = lit, 3 = darkest).
+#define LIGHT_MAP_CELL(north, east, south, west) ((north) | ((east) << 2) | ((south) << 4) | ((west) << 6)) // Write a light map byte from the light level of each face.
+#define RAY_MODE_ANGLE 0               // 3D views rays are one degree apart, and their lengths are corrected with the cosinus of their angle to the player orientation. Can be used with the ARCE.rayMode variable.
+#define RAY_MODE_CAMERA_PLANE 1        // 3D views rays go through evenly spaced points of a camera plane, and their lengths are the perpendicular distances. Can be used with the ARCE.rayMode variable.
+#define RESOLUTION_HIGH 0              // 3D views are rendered with 64 rays (2 pixels wide slices). Can be used with the ARCE.resolution variable.
+#define RESOLUTION_LOW 1               // 3D views are rendered with 32 rays (4 pixels wide slices). Can be used with the ARCE.resolution variable.
+#define RESOLUTION_ADAPTIVE 2          // 3D views resolution follows the render time (see ARCE.targetRenderMicros). Can be used with the ARCE.resolution variable.
+#define ENTITY_ACTIVE 1                // Entity flag : the entity slot is used. Can be used with the ARCEEntities.flags array.
+#define ENTITY_BLOCKED_X 2             // Entity flag set by ARCE::updateEntities() : the X move of the entity was stopped by a block during the last step.
+#define ENTITY_BLOCKED_Y 4             // Entity flag set by ARCE::updateEntities() : the Y move of the entity was stopped by a block during the last step.
+#define ENTITY_USER 16                 // First entity flag free for the game (ENTITY_USER, ENTITY_USER << 1, ...). Can be used with the ARCEEntities.flags array.
+#define REPLAY_OFF 0                   // Replay mode : the player input is not recorded nor replayed. Can be used with the ARCEReplay.mode variable.
+#define REPLAY_RECORD 1                // Replay mode : the player input of each frame is recorded in a session. Can be used with the ARCEReplay.mode variable.
+#define REPLAY_PLAY 2                  // Replay mode : the player input of each frame is read from a session. Can be used with the ARCEReplay.mode variable.
+#define REPLAY_DONE 3                  // Replay mode : the session has ended (or the recording buffer is full). Can be used with the ARCEReplay.mode variable.
+#define REPLAY_NO_FRAME 0xFFFF         // No frame. Can be used with the ARCEReplay.firstFailedFrame variable.
+#define REPLAY_RUN(moveDir, rotDir, frames) ((((moveDir) + 1) & 3) | ((((rotDir) + 1) & 3) << 2) | (((frames) - 1) << 4)) // Write a run of a replay session : the same moveDir and rotDir during 1 to REPLAY_RUN_MAX_FRAMES frames.
 #define MULTIPLY_BY_2 1                // Can be used in a bit shift operation in order to multiply a value by 2. 
 #define DIVIDE_BY_2 1                  // Can be used in a bit shift operation in order to divide a value by 2.
 #define MULTIPLY_BY_8 3                // Can be used in a bit shift operation in order to multiply a value by 8.
@@ -94,6 +165,7 @@
 #define MULTIPLY_BY_BLOCK_SIZE 6             // Can be used in a bit shift operation in order to multiply a value by the block size.
 #define DIVIDE_BY_BLOCK_SIZE 6               // Can be used in a bit shift operation in order to divide a value by the block size.
 #define PROJECTION_K 6528                    // Constant used for projection. You can find an explanation of this constant at the projection section in the ARCE.cpp source code.
+#define PROJECTION_DISTANCE 102              // Distance between the player and the projection plane (screen coordinates) : HALF_SCREEN_WIDTH / tan(HALF_FOV).
 #define K 128                                // Constant used to perform floating point calculations with integers.
 #define MULTIPLY_BY_K 7                      // Can be used in a bit shift operation in order to multiply a value by K.
 #define DIVIDE_BY_K 7                        // Can be used in a bit shift operation in order to divide a value by K.
@@ -103,7 +175,120 @@
 #define MULTIPLY_BY_TEXTURE_SCALING_FACTOR 1 // Can be used in a bit shift operation in order to multiply a value by the texture scaling factor.
 #define DIVIDE_BY_TEXTURE_SCALING_FACTOR 1   // Can be used in a bit shift operation in order to divide a value by the texture scaling factor.
 #define PLAYER_COLLISION_MIN_DIST 1          // Constant used to calculate the minimal distance between the player and a block.  
-#define WORLD_TO_SCREEN_SCALING_FACTOR 16    // Scaling factor between world coordinates and screen coordinates.
+#define RAY_COUNT 64                         // Number of rays cast for a 3D view (one ray for each 2 pixels wide slice).
+#define SURFACE_SEGMENT_SIZE 8               // Number of rays between two exactly calculated floor/ceiling points. The points in between are linearly interpolated.
+#define DIVIDE_BY_SURFACE_SEGMENT_SIZE 3     // Can be used in a bit shift operation in order to divide a value by the surface segment size.
+#define SURFACE_MAX_DISTANCE 1024            // Floor and ceiling rows farther than this distance are not rendered (world coordinates). It avoids aliasing near the horizon.
+#define SHADE_BAND_COUNT 32                  // Number of entries in the shadeBands array (one entry for each block of distance).
+#define SHADE_DARKEST_BAND 5                 // Last shade band of the shadeMasks array. The shadings add their bands up to this one.
+#define FOG_BAND_SIZE 128                    // Depth of the fog band before the view distance, where the SHADING_FOG shading adds its bands (world coordinates).
+#define DIVIDE_BY_FOG_BAND_SIZE 7            // Can be used in a bit shift operation in order to divide a value by the fog band size.
+#define QUERY_MAX_DELTA 16384                // Longest X or Y length of a query cast in a direction (world coordinates). It crosses the widest world, and the target stays in the int16 range.
+#define TRANSPARENT_MAX_HITS 4               // Maximum number of see-through blocks (blocks with a masked texture) rendered by a ray. The next one stops the ray.
+#define MAP_SUBPIXEL_BITS 2                  // Number of fractional bits of the field of view polygon coordinates in the VIEW_2D view (1/4 pixel).
+#define VIEWPORT_ALIGNMENT 4                 // The X position and the width of the 3D views viewport are multiples of this value (width of a low resolution slice).
+#define VIEWPORT_MIN_HEIGHT 2                // Minimum height of the 3D views viewport (screen coordinates).
+#define LEVEL_PACK_VERSION 2                 // Version of the level pack format read by the engine.
+#define LEVEL_PACK_HEADER_SIZE 22            // Size of a level pack header (bytes).
+#define LEVEL_PACK_CHUNK_SIZE 64             // Size of the chunks read by ARCE::streamLevelPack() (bytes).
+#define MINIMAP_WIDTH 32                     // Minimap width (screen coordinates).
+#define MINIMAP_HEIGHT 16                    // Minimap height (screen coordinates). The minimap covers the 2 first pages of the screen buffer.
+#define MINIMAP_PAGES 2                      // Number of screen buffer pages covered by the minimap.
+#define DIRTY_ALL_PAGES 255                  // Can be used with ARCE::markDirty() in order to mark all the screen buffer pages.
+#define DIRTY_FULL_REFRESH_FRAMES 64         // Number of frames between two full refreshes of the display when the dirty tracking is used.
+#define SIMULATION_TICK_MICROS 33333         // Default duration of a simulation tick run by ARCE::step() (30 ticks per second).
+#define RESOLUTION_TARGET_MICROS 40000       // Default render time target of the RESOLUTION_ADAPTIVE resolution (microseconds).
+#define RESOLUTION_SWITCH_FRAMES 4           // Number of frames in a row needed to switch the resolution in RESOLUTION_ADAPTIVE resolution.
+#define REPLAY_RUN_MAX_FRAMES 16             // Maximum number of frames of a replay session run (one byte for each run).
+#define DIVIDE_BY_REPLAY_RUN_MAX_FRAMES 4    // Can be used in a bit shift operation in order to divide a value by the maximum number of frames of a run.
+#define SIMULATION_MAX_TICKS 4               // Maximum number of simulation ticks run by a single ARCE::step() call. When more ticks are late, the frame is skipped.
+
+// ARCE profiling. Uncomment the ARCE_PROFILE line in order to measure the engine hot paths in ARCE.stats (see the ARCEStats class below).
+// Without it, the measurements are not compiled at all.
+// #define ARCE_PROFILE
+#ifdef ARCE_PROFILE
+#define ARCE_PROFILE_COUNT(counter, value) stats.counter += (value)                // Add a value to a counter of the current frame statistics.
+#define ARCE_PROFILE_START(timer) uint32_t timer##StartMicros = micros()           // Start a timer of the current frame statistics.
+#define ARCE_PROFILE_RESTART(timer) timer##StartMicros = micros()                // Start again a timer already started in the same function.
+#define ARCE_PROFILE_STOP(timer) stats.timer##Micros += micros() - timer##StartMicros // Stop a timer and add its elapsed time to the current frame statistics.
+#else
+#define ARCE_PROFILE_COUNT(counter, value)
+#define ARCE_PROFILE_START(timer)
+#define ARCE_PROFILE_RESTART(timer)
+#define ARCE_PROFILE_STOP(timer)
+#endif
+
+// ARCE assets location. The world maps, textures, block heights, level packs and replay sessions are read from the flash memory (PROGMEM) by 
+// default. Uncomment the ARCE_ASSETS_IN_RAM line (or use a compiler flag) in order to read them from the RAM : level packs streamed from an external
+// storage with ARCE::streamLevelPack(). The engine tables always stay in the flash memory. Host builds read everything from the RAM (see ARCE_HOST 
+// above).
+// #define ARCE_ASSETS_IN_RAM
+#ifdef ARCE_ASSETS_IN_RAM
+#define ARCE_READ_BYTE(address) (*(const uint8_t *)(address))
+#define ARCE_READ_WORD(address) ((uint16_t)ARCE_READ_BYTE(address) | ((uint16_t)ARCE_READ_BYTE((const uint8_t *)(address) + 1) << 8))
+#else
+#define ARCE_READ_BYTE(address) pgm_read_byte(address)
+#define ARCE_READ_WORD(address) pgm_read_word(address)
+#endif
+
+// ARCE map cache size (bytes). The 2D views read the blocks from a 1 bit per block copy of the world map when it fits in this size. This value can be
+// overridden with a compiler flag.
+#ifndef ARCE_MAP_CACHE_SIZE
+#define ARCE_MAP_CACHE_SIZE 64               // Size of the map cache : 64 bytes hold a 32 x 16 world map.
+#endif
+
+// ARCE entities settings. These values can be overridden with compiler flags (host simulations can use thousands of entities).
+#ifndef ARCE_MAX_ENTITIES
+#define ARCE_MAX_ENTITIES 32                 // Maximum number of entities in an entities store.
+#endif
+#ifndef ENTITY_HASH_SIZE
+#define ENTITY_HASH_SIZE 32                  // Number of buckets of the entities spatial hash. Must be a power of 2, at least 32.
+#endif
+#if ENTITY_HASH_SIZE < 32 || (ENTITY_HASH_SIZE & (ENTITY_HASH_SIZE - 1))
+#error "ENTITY_HASH_SIZE must be a power of 2, at least 32 : the 9 blocks around a block must use different buckets (see ARCEEntities::getBucket())"
+#endif
+// Level pack reader : reads size bytes of a level pack from an external storage (SD card, serial flash...), starting at a given offset. Returns the 
+// number of bytes read.
+typedef uint16_t (*ARCELevelPackReader)(uint32_t offset, uint8_t *destination, uint16_t size);
+
+#if ARCE_MAX_ENTITIES < 255
+typedef uint8_t ARCEEntityIndex;             // Index of an entity in an entities store.
+#define ENTITY_NONE 255                      // Index used for "no entity" (end of a spatial hash bucket, full entities store, etc...).
+#else
+typedef uint16_t ARCEEntityIndex;            // Index of an entity in an entities store.
+#define ENTITY_NONE 65535                    // Index used for "no entity" (end of a spatial hash bucket, full entities store, etc...).
+#endif
+
+// Texture descriptor.
+// Each texture array starts with a TEXTURE_DESCRIPTOR_SIZE bytes descriptor :
+//   - byte 0 : texture width, as a power of 2 (TEXTURE_SIZE_16, TEXTURE_SIZE_32, TEXTURE_SIZE_64, ...).
+//   - byte 1 : texture height, as a power of 2.
+//   - byte 2 : packing format : TEXTURE_FORMAT_ROW_MAJOR, TEXTURE_FORMAT_COLUMN_MAJOR or TEXTURE_FORMAT_RLE.
+//   - byte 3 : flags : number of levels of detail following the texture (0 to 15) and TEXTURE_MASKED.
+// The descriptor is followed by the texels. Each level of detail is half as wide and half as high as the previous one, and the last level of detail is
+// one byte whose bits all equal the average texel. A masked texture is followed by its mask, stored with the same layout as the texels.
+// Each level of an RLE texture starts with width + 1 column offsets (TEXTURE_RLE_OFFSET, from the start of the level, the last one is the size of the
+// level) followed by the runs of each column, from top to bottom. A run byte is TEXTURE_RLE_VALUE for white texels plus the number of texels (1 to 127).
+// RLE textures are rendered run by run with whole screen buffer bytes, which suits textures made of long vertical runs. RLE textures can't be masked.
+// 16 x 16 textures are cheaper in flash memory, 64 x 64 textures show more details : the texture always covers the whole block face.
+
+// Level pack.
+// A level pack holds a whole level in one binary block. All the 16 bits values are stored low byte first (LEVEL_PACK_WORD) and all the offsets 
+// start from the beginning of the pack, so a pack can be read in place from the flash memory, from the RAM or from a file mapped in memory :
+//   - bytes 0 to 3 : LEVEL_PACK_MAGIC ('A', 'R', 'C', 'L').
+//   - byte 4 : format version (LEVEL_PACK_VERSION).
+//   - byte 5 : world map encoding (LEVEL_MAP_RAW : one byte for each block, row by row).
+//   - byte 6 : world map width.
+//   - byte 7 : world map height.
+//   - bytes 8 and 9 : world map offset.
+//   - byte 10 : number of textures (one for each block type, texture descriptor and texels : see the texture descriptor above).
+//   - byte 11 : number of spawn points.
+//   - bytes 12 and 13 : textures table offset. The table holds the offset of each texture (16 bits).
+//   - bytes 14 and 15 : spawn points offset. Each spawn point is the X position, the Y position (world coordinates) and the rotation (degrees) of the
+//     player (3 x 16 bits).
+//   - bytes 16 and 17 : block heights offset (one byte for each texture, see ARCE::loadBlockHeights()), or 0 when all the blocks are BLOCK_SIZE high.
+//   - bytes 18 and 19 : level pack size.
+//   - bytes 20 and 21 : light map offset (see ARCE::loadLightMap()), or 0 when the level has no light map.
 
 // Cosinus array for player rotation.
 // Each cosinus value is multiplied by 16 in order to use integers instead of floats.
@@ -162,6 +347,41 @@ PROGMEM const uint8_t cosBy128[91] = {
   22, 20, 18, 16, 13, 11, 9, 7, 4, 2, 0
 };
 
+// Floor and ceiling rows distances.
+// surfaceRowDistance[r] is the straight distance (world coordinates) between the player and the floor point seen on the screen row HALF_SCREEN_HEIGHT + r
+// (or the ceiling point seen on the screen row HALF_SCREEN_HEIGHT - 1 - r). Each value equals to (BLOCK_SIZE / 2) * 102 / (r + 0.5) : see the projection 
+// section in the ARCE.cpp source code.
+PROGMEM const uint16_t surfaceRowDistance[HALF_SCREEN_HEIGHT] = {
+
+  6528, 2176, 1306, 933, 725, 593, 502, 435, 384, 344, 
+  311, 284, 261, 242, 225, 211, 198, 187, 176, 167, 
+  159, 152, 145, 139, 133, 128, 123, 119, 115, 111, 
+  107, 104
+};
+
+// Shade band of a slice for each block of distance : shadeBands[rayLength / BLOCK_SIZE].
+// Slices farther than SHADE_BAND_COUNT blocks use the last band. 
+PROGMEM const uint8_t shadeBands[SHADE_BAND_COUNT] = {
+
+  0, 0, 1, 1, 2, 2, 3, 3, 3, 4, 
+  4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 
+  4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 
+  4, 4
+};
+
+// Ordered dither (4 x 4 Bayer matrix) masks for each shade band. 
+// shadeMasks[shadeBand * 4 + (x % 4)] is the mask of an 8 pixels high screen buffer byte at the screen X position x.
+// The darkest bands are only reached when several shadings are added (SHADING_SIDE, SHADING_LIGHT_MAP, SHADING_FOG).
+PROGMEM const uint8_t shadeMasks[24] = {
+
+  0b11111111, 0b11111111, 0b11111111, 0b11111111, // 16 pixels of 16 are lit
+  0b01010101, 0b11111111, 0b01010101, 0b11111111, // 12 pixels of 16 are lit
+  0b01010101, 0b10101010, 0b01010101, 0b10101010, // 8 pixels of 16 are lit
+  0b01010101, 0b00100010, 0b01010101, 0b00000000, // 5 pixels of 16 are lit
+  0b00010001, 0b00000000, 0b01010101, 0b00000000, // 3 pixels of 16 are lit
+  0b00010001, 0b00000000, 0b00000000, 0b00000000  // 1 pixel of 16 is lit
+};
+
 // ------------------------------------------------------------------------------------------------------------------------------------------------------
 // Player Class
 // ------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -180,6 +400,134 @@ class ARCEPlayer {
     ARCEPlayer();                      // Player Class constructor.
 };
 
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Statistics Class
+// Hot paths counters and timers of a frame, filled when ARCE_PROFILE is defined. A frame ends with ARCE::displayFrame().
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+class ARCEStats {
+  
+  public:
+  
+    uint16_t rays = 0;           // Number of rays cast.
+    uint16_t vccSteps = 0;       // Number of blocks checked by the vertical collision checks of the rays.
+    uint16_t hccSteps = 0;       // Number of blocks checked by the horizontal collision checks of the rays.
+    uint16_t mapReads = 0;       // Number of world map reads (rays, queries, collisions).
+    uint16_t texelFetches = 0;   // Number of texels (or texel runs) read from the textures.
+    uint16_t pixelsWritten = 0;  // Number of pixels written into the screen buffer by the 3D views.
+    uint16_t displayBytes = 0;   // Number of screen buffer bytes sent to the display.
+    uint32_t simulateMicros = 0; // Time spent in the simulation : player and entities moves (microseconds).
+    uint32_t traceMicros = 0;    // Time spent in the rays collision checks (microseconds).
+    uint32_t rasterMicros = 0;   // Time spent drawing the slices, the floor, the ceiling and the 2D map (microseconds).
+    uint32_t displayMicros = 0;  // Time spent sending the screen buffer to the display (microseconds).
+    
+    ARCEStats();                 // Statistics Class constructor.
+};
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Ray Query Class
+// A line of sight or hitscan query between an origin and a target point, answered by ARCE::castQuery() without drawing anything.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+class ARCERayQuery {
+  
+  public:
+  
+    int16_t originX = 0;     // X position of the query origin (world coordinates).
+    int16_t originY = 0;     // Y position of the query origin (world coordinates).
+    int16_t targetX = 0;     // X position of the query target (world coordinates). The query stops at the target.
+    int16_t targetY = 0;     // Y position of the query target (world coordinates).
+    bool hit = false;        // Result : tells if a block was hit between the origin and the target.
+    uint8_t blockXOnMap = 0; // Result : X position of the block hit in the world map (world map coordinates).
+    uint8_t blockYOnMap = 0; // Result : Y position of the block hit in the world map (world map coordinates).
+    uint8_t blockType = 0;   // Result : type of the block hit. That's the block number in the world map : wall, door, etc...
+    int16_t hitX = 0;        // Result : X position of the point hit on the block face (world coordinates).
+    int16_t hitY = 0;        // Result : Y position of the point hit on the block face (world coordinates).
+    uint16_t distance = 0;   // Result : distance between the origin and the point hit (world coordinates).
+    
+    ARCERayQuery();          // Ray Query Class constructor.
+};
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Entities Class
+// Entities (enemies, items, projectiles, etc...) are stored as a structure of arrays : a batched step only reads the arrays it needs.
+// Each entity is linked in a spatial hash bucket according to the block it stands on, so proximity queries only look at the nearby blocks whatever the
+// world map size. Entities must stay inside the world and their radius must be lower than BLOCK_SIZE / 2.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+class ARCEEntities {
+  
+  public:
+    
+    int16_t x[ARCE_MAX_ENTITIES];         // X position of each entity (world coordinates). Use setPosition() to move an entity.
+    int16_t y[ARCE_MAX_ENTITIES];         // Y position of each entity (world coordinates). Use setPosition() to move an entity.
+    int8_t velocityX[ARCE_MAX_ENTITIES];  // X move of each entity for each step of ARCE::updateEntities() (world coordinates). Moves of BLOCK_SIZE or more are split in two.
+    int8_t velocityY[ARCE_MAX_ENTITIES];  // Y move of each entity for each step of ARCE::updateEntities() (world coordinates).
+    uint8_t radius[ARCE_MAX_ENTITIES];    // Collision radius of each entity (world coordinates).
+    uint8_t flags[ARCE_MAX_ENTITIES];     // Flags of each entity : ENTITY_ACTIVE, ENTITY_BLOCKED_X, ENTITY_BLOCKED_Y and the game flags (ENTITY_USER, ...).
+    ARCEEntityIndex count = 0;            // Number of entity slots in use (highest active entity index + 1). Loops over the entities stop there.
+    
+    ARCEEntities();                                                      // Entities Class constructor.
+    ARCEEntityIndex add(int16_t x, int16_t y, uint8_t radius);           // Add an entity at a given position. Returns its index or ENTITY_NONE if the store is full.
+    void remove(ARCEEntityIndex entity);                                 // Remove a given entity.
+    void setPosition(ARCEEntityIndex entity, int16_t x, int16_t y);      // Move a given entity to a given position.
+    ARCEEntityIndex findEntities(int16_t x, int16_t y, uint16_t distance, ARCEEntityIndex *entities, ARCEEntityIndex maxEntities); // Find the entities near a given position.
+    
+  private:
+    
+    uint8_t blockX[ARCE_MAX_ENTITIES];                  // X position of the block of each entity (world map coordinates).
+    uint8_t blockY[ARCE_MAX_ENTITIES];                  // Y position of the block of each entity (world map coordinates).
+    ARCEEntityIndex nextInBucket[ARCE_MAX_ENTITIES];    // Next entity in the spatial hash bucket of each entity.
+    ARCEEntityIndex firstInBucket[ENTITY_HASH_SIZE];    // First entity of each spatial hash bucket.
+    
+    uint16_t getBucket(uint8_t blockX, uint8_t blockY); // Get the spatial hash bucket of a given block.
+    void link(ARCEEntityIndex entity);                  // Link a given entity in the spatial hash bucket of its block.
+    void unlink(ARCEEntityIndex entity);                // Unlink a given entity from its spatial hash bucket.
+};
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Replay Class
+// Records the player input of each frame (moveDir and rotDir) in a session, or plays a session back instead of the buttons. While a session is 
+// recorded or played, ARCE::step() runs exactly one simulation tick per frame, so the same session always gives the same frames whatever the frame 
+// rate. Each rendered frame is hashed : a played session can be checked against the golden hashes of a previous run, and against a render time 
+// budget. The options which depend on the time (RESOLUTION_ADAPTIVE resolution) must not be used while a session is played.
+// A session is a list of runs written with REPLAY_RUN() : one byte for the same input during 1 to REPLAY_RUN_MAX_FRAMES frames.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+class ARCEReplay {
+  
+  public:
+  
+    uint8_t mode = REPLAY_OFF;            // Replay mode : REPLAY_OFF, REPLAY_RECORD, REPLAY_PLAY or REPLAY_DONE.
+    uint16_t frame = 0;                   // Number of frames rendered since the session start.
+    uint16_t *frameHashes = 0;            // Array receiving the hash of each frame, used to make the golden hashes of a session (optional).
+    uint16_t frameHashesSize = 0;         // Size of the frameHashes array (frames).
+    uint32_t renderBudgetMicros = 0;      // Render time budget of a frame when a session is played (microseconds, 0 = no budget).
+    uint16_t failedFrames = 0;            // Result : number of played frames whose hash differs from the golden hash.
+    uint16_t firstFailedFrame = REPLAY_NO_FRAME; // Result : first played frame whose hash differs from the golden hash.
+    uint16_t overBudgetFrames = 0;        // Result : number of played frames rendered over the render time budget.
+    uint32_t maxRenderMicros = 0;         // Result : longest render time of the session (microseconds).
+    uint32_t totalRenderMicros = 0;       // Result : render time of the whole session (microseconds).
+    
+    ARCEReplay();                                                                       // Replay Class constructor.
+    void record(uint8_t *session, uint16_t sessionMaxSize);                              // Start recording the player input in a given RAM array.
+    void play(const uint8_t *session, uint16_t sessionSize, const uint16_t *goldenHashes); // Start playing a given session (asset). goldenHashes (asset) can be 0.
+    void stop();                                                                        // Stop recording or playing.
+    bool passed();                                                                      // Tells if all the played frames matched their golden hash and the render time budget.
+    uint16_t getSessionSize();                                                          // Get the size of the recorded session (bytes).
+#ifndef ARCE_HOST
+    void printSession();                                                                // Print the recorded session and the frame hashes over Serial, as C++ arrays.
+#endif
+    void readInput(ARCEPlayer *player);                                                 // Record or play the input of the next frame. Called by the engine for each frame.
+    void checkFrame(const uint8_t *buffer, uint32_t renderMicros);                      // Hash a rendered frame and check it. Called by the engine at the end of each render.
+    static uint16_t hashFrame(const uint8_t *buffer);                                   // Get the hash (CRC-CCITT) of a screen buffer.
+    
+  private:
+    
+    uint8_t *recordedSession = 0;         // Recorded session (RAM).
+    const uint8_t *playedSession = 0;     // Played session (asset, see ARCE_ASSETS_IN_RAM).
+    const uint16_t *goldenHashes = 0;     // Golden hash of each frame of the played session (asset, see ARCE_ASSETS_IN_RAM), or 0.
+    uint16_t sessionSize = 0;             // Size of the recorded session array, or size of the played session (bytes).
+    uint16_t sessionPos = 0;              // Position of the current run in the session.
+    uint8_t runFrames = 0;                // Number of frames recorded in the current run, or number of frames left in the current played run.
+};
+
 // ------------------------------------------------------------------------------------------------------------------------------------------------------
 // ARCE Engine Class
 // ------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -188,24 +536,151 @@ class ARCE {
   public:
     
     ARCEPlayer player;                 // Player object.
+#ifdef ARCE_HOST
+    uint8_t screenBuffer[SCREEN_BUFFER_SIZE] = { 0 }; // Screen buffer of the host builds, in the Arduboy screen buffer layout. Used instead of the Arduboy one.
+    uint8_t displayMemory[SCREEN_BUFFER_SIZE] = { 0 }; // Display memory of the host builds : what the display shows, written by displayFrame() in the display windows.
+#else
     Arduboy display;                   // Arduboy library object.
+#endif
     uint8_t view = VIEW_3D_TEXTURED;   // Current view : VIEW_2D_ONERAY, VIEW_2D, VIEW_3D_SOLID or VIEW_3D_TEXTURED.
-    const uint8_t *texturesArray[256]; // Textures array : texturesArray[0] is used with block "1" in world map, etc...
+    bool minimap = false;              // Tells if a minimap is drawn over the top of the 3D views.
+    uint8_t minimapX = 0;              // X position of the minimap (screen coordinates). Should be a multiple of 4, so no slice is partly under the minimap.
+    uint8_t mapZoom = MAP_ZOOM_4;      // Zoom of the 2D views : MAP_ZOOM_1, MAP_ZOOM_2, MAP_ZOOM_4 or MAP_ZOOM_8. The map scrolls with the player when it is larger than the screen.
+    const uint8_t *texturesArray[256]; // Textures array : texturesArray[0] is used with block "1" in world map, etc... Each texture starts with its descriptor (see below).
+    uint8_t floorMode = SURFACE_NONE;   // Floor rendering mode in 3D views : SURFACE_NONE, SURFACE_CHECKERBOARD or SURFACE_TEXTURED.
+    uint8_t ceilingMode = SURFACE_NONE; // Ceiling rendering mode in 3D views : SURFACE_NONE, SURFACE_CHECKERBOARD or SURFACE_TEXTURED.
+    const uint8_t *floorTexture;        // Floor texture (row-major) used with the SURFACE_TEXTURED mode.
+    const uint8_t *ceilingTexture;      // Ceiling texture (row-major) used with the SURFACE_TEXTURED mode.
+    uint8_t shadingMode = SHADING_NONE; // Slices shading in 3D views : SHADING_NONE, or any combination of SHADING_DISTANCE, SHADING_SIDE, SHADING_LIGHT_MAP and SHADING_FOG.
+    uint32_t tickMicros = SIMULATION_TICK_MICROS; // Duration of a simulation tick run by step() (microseconds). Player moveStep and rotStep are applied once per tick.
+    ARCEEntities *entities = 0;         // Entities store moved at each simulation tick (optional).
+    ARCEReplay *replay = 0;             // Replay recording or playing the player input and checking the frames (optional).
+    uint16_t viewDistance = 0;          // Maximum distance seen in 3D views (world coordinates, 0 = whole world). The rays stop there, and the blocks, floor and ceiling beyond are left to the background.
+    uint8_t rayMode = RAY_MODE_ANGLE;   // Rays of the 3D views : RAY_MODE_ANGLE or RAY_MODE_CAMERA_PLANE (straight walls stay straight, no per-ray trigonometry).
+    uint8_t resolution = RESOLUTION_HIGH; // Resolution of the 3D views : RESOLUTION_HIGH, RESOLUTION_LOW or RESOLUTION_ADAPTIVE.
+    uint16_t targetRenderMicros = RESOLUTION_TARGET_MICROS; // Render time target of the RESOLUTION_ADAPTIVE resolution (microseconds).
+    uint32_t renderMicros = 0;          // Duration of the last render() call (microseconds).
+    bool clearAfterDisplay = false;     // Tells if displayFrame() clears the screen buffer while sending it to the display.
+    bool dirtyTracking = false;         // Tells if displayFrame() only sends the screen buffer pages drawn in this frame or in the last one (see markDirty()).
+#ifdef ARCE_PROFILE
+    ARCEStats stats;                    // Statistics of the current frame.
+    ARCEStats frameStats;               // Statistics of the last complete frame.
+#endif
     
     ARCE();                                            // ARCE Engine Class constructor    
     void start();                                      // Initialize ARCE Engine. Can be called inside the Arduino "setup()" function. Used instead of "ARCE()" constructor.
     void update();                                     // Must be called every frame. Can be placed inside the Arduino "loop()" function.
-    void castRay(uint8_t rayNumber, int16_t rayAngle); // Cast a ray with a given number and a given angle.
+    bool step();                                       // Run the elapsed simulation ticks (fixed timestep). Returns true if a frame should be rendered.
+    void setRenderTarget(uint8_t *target);             // Render into a given screen buffer (SCREEN_BUFFER_SIZE bytes, in the Arduboy screen buffer layout). 0 = Arduboy screen buffer (screenBuffer in host builds).
+    void setViewport(uint8_t x, uint8_t y, uint8_t width, uint8_t height); // Set the rectangle of the render target used by the 3D views (screen coordinates).
+    void simulate();                                   // Run one simulation tick : player and entities moves.
+    void render();                                     // Render the current view into the screen buffer.
+    void displayFrame();                               // Send the screen buffer to the display and end the frame.
+    void markDirty(uint8_t page);                      // Mark a screen buffer page (or DIRTY_ALL_PAGES) as drawn, for the drawings made outside of the engine.
+#if defined(ARCE_PROFILE) && !defined(ARCE_HOST)
+    void printStats();                                 // Print the statistics of the last complete frame over Serial.
+#endif
+    void castRay(uint8_t rayNumber, int16_t rayAngle, int16_t rayDirXBy128 = 0, int16_t rayDirYBy128 = 0); // Cast a ray with a given number and a given angle, or a given camera plane direction.
+    void updateEntities(ARCEEntities *entities);                                         // Move all the entities of a given store by one step, sliding along the blocks.
+    bool isSolid(int16_t x, int16_t y);                                                  // Tells if a given point of the world is inside a block or outside the world.
+    bool castQuery(ARCERayQuery *query);                                                 // Find the first block between the origin and the target of a query. Returns true if a block was hit.
+    bool castQuery(ARCERayQuery *query, int16_t angle, uint16_t maxDistance);            // Find the first block in a given direction from the origin of a query, up to a given distance (0 = whole world).
+    uint8_t castQueries(ARCERayQuery *queries, uint8_t queryCount);                      // Answer several queries, sharing the origin setup of consecutive queries. Returns the number of queries with a clear line of sight.
     void loadWorldMap(const uint8_t *worldMap, uint8_t worldMapWidth, uint8_t worldMapHeight);                              // Load a given world map in the engine.
+    bool loadLevelPack(const uint8_t *levelPack);                                                                           // Load the world map, textures, block heights and light map of a level pack. Returns false if the pack is not valid.
+    bool spawnPlayer(uint8_t spawnPoint);                                                                                   // Move the player to a given spawn point of the loaded level pack. Returns false if there is no such spawn point.
+    const uint8_t *streamLevelPack(ARCELevelPackReader reader, uint8_t *levelBuffer, uint16_t levelBufferSize);            // Read a level pack from an external storage into a RAM buffer and load it. Returns 0 on failure.
+#ifdef ARCE_HOST
+    static const uint8_t *mapLevelPack(const char *path);                                                                   // Map a level pack file in memory (host builds). Returns 0 on failure.
+#endif
+    void loadLightMap(const uint8_t *lightMap);                                                                             // Load the baked light of each block face of the world map (0 = no light map).
+    void loadBlockHeights(const uint8_t *blockHeights, uint8_t blockTypeCount);                                             // Load the height of each block type (0 = all blocks are BLOCK_SIZE high).
     uint8_t getTexel (uint8_t texelX, uint8_t texelY, const uint8_t *texture, uint8_t textureWidth, uint8_t textureHeight); // Read a pixel from a given texture.
     
   private:
     
-    const uint8_t *worldMap;    // Current world map. 
-    uint8_t worldMapWidth = 0;  // World map width.
-    uint8_t worldMapHeight = 0; // World map height.
-    uint16_t worldWidth = 0;    // World width.
-    uint16_t worldHeight = 0;   // World height.
+    const uint8_t *worldMap;            // Current world map. 
+    uint8_t worldMapWidth = 0;          // World map width.
+    uint8_t worldMapHeight = 0;         // World map height.
+    uint16_t worldWidth = 0;            // World width.
+    uint16_t worldHeight = 0;           // World height.
+    bool enclosedWorldMap = false;      // Tells if all the blocks of the world map border are solid : the rays cast from inside skip most of the world borders tests.
+    uint8_t mapCache[ARCE_MAP_CACHE_SIZE]; // Copy of the world map with 1 bit per block (1 = solid), row by row, used by the 2D views.
+    uint8_t mapCacheRowSize = 0;        // Size of a row of the map cache (bytes). 0 when the world map does not fit in the map cache.
+    uint8_t minimapBitmap[MINIMAP_WIDTH * MINIMAP_PAGES]; // Downsampled world map drawn by the minimap, in the screen buffer layout (2 pages of MINIMAP_WIDTH bytes).
+    uint8_t minimapShift = 0;           // Minimap downsampling : each minimap pixel covers 2^minimapShift x 2^minimapShift blocks.
+    int16_t mapScrollX = 0;             // X position of the 2D views viewport on the map (screen coordinates).
+    int16_t mapScrollY = 0;             // Y position of the 2D views viewport on the map (screen coordinates).
+    int16_t previousHitX = 0;           // X position of the previous ray hit on the screen, with MAP_SUBPIXEL_BITS fractional bits. Used by the VIEW_2D view.
+    int16_t previousHitY = 0;           // Y position of the previous ray hit on the screen, with MAP_SUBPIXEL_BITS fractional bits. Used by the VIEW_2D view.
+    const uint8_t *levelPack = 0;       // Loaded level pack, or 0 when the world map was loaded with loadWorldMap().
+    const uint8_t *lightMap = 0;        // Baked light of each block face, one byte for each block of the world map (PROGMEM), or 0.
+    const uint8_t *blockHeights = 0;    // Height of each block type (world coordinates, PROGMEM), or 0 when all the blocks are BLOCK_SIZE high.
+    uint8_t maxBlockHeight = BLOCK_SIZE; // Height of the highest block type (world coordinates).
+    int16_t queryOriginX = 0;           // X position of the origin set up for the next queries (world coordinates).
+    int16_t queryOriginY = 0;           // Y position of the origin set up for the next queries (world coordinates).
+    int16_t queryCellX = 0;             // X position of the cell of the queries origin (world map coordinates).
+    int16_t queryCellY = 0;             // Y position of the cell of the queries origin (world map coordinates).
+    int16_t queryMapPos = 0;            // Position of the cell of the queries origin in the world map (queryCellY * worldMapWidth + queryCellX).
+    uint8_t *buffer = 0;                // Render target : Arduboy screen buffer or a buffer in the same layout (8 pages of 128 bytes, each byte is a 8 pixels high column).
+    uint8_t viewportY = 0;              // Y position of the first row of the 3D views viewport (screen coordinates).
+    uint8_t viewportStopY = SCREEN_HEIGHT; // Y position of the row after the last row of the 3D views viewport (screen coordinates).
+    uint8_t viewportFirstRay = 0;       // First ray cast in the 3D views viewport.
+    uint8_t viewportStopRay = RAY_COUNT; // Ray after the last ray cast in the 3D views viewport.
+    uint8_t viewportCentreRay = HALF_FOV; // Ray looking in the player orientation : the ray at the centre of the 3D views viewport.
+    uint8_t horizonY = HALF_SCREEN_HEIGHT; // Y position of the horizon : the row at the centre of the 3D views viewport (screen coordinates).
+    uint8_t viewportCoverage[SCREEN_HEIGHT >> 3] = { 0 }; // Rows outside of the 3D views viewport, one byte for each page. Copied into sliceCoverage at the first see-through block.
+    uint32_t lastStepMicros = 0;        // Time of the last step() call (microseconds).
+    uint32_t tickAccumulatorMicros = 0; // Time elapsed and not simulated yet (microseconds).
+    bool frameSkipped = false;          // Tells if the last step() call skipped its frame because the simulation was behind.
+    uint8_t rayStep = 1;                // Step between two cast rays : 1 for 64 rays, 2 for 32 rays.
+    uint8_t sliceWidth = 2;             // Width of the slices (screen coordinates) : 2 for 64 rays, 4 for 32 rays.
+    bool adaptiveLowResolution = false; // Tells if the RESOLUTION_ADAPTIVE resolution currently uses the low resolution.
+    uint8_t resolutionSwitchFrames = 0; // Number of frames in a row asking for the other resolution.
+    uint8_t dirtyPages = 0;             // Screen buffer pages drawn in the current frame, one bit for each page (dirty tracking).
+    uint8_t lastDirtyPages = 0;         // Screen buffer pages drawn in the last frame : they are sent again, as they may have been cleared since.
+    uint8_t framesSinceFullRefresh = 0; // Number of frames since the last full refresh of the display (dirty tracking).
+#ifdef ARCE_HOST
+    uint8_t displayFirstColumn = 0;     // First column of the display window (host builds display controller).
+    uint8_t displayLastColumn = SCREEN_WIDTH - 1; // Last column of the display window (host builds display controller).
+    uint8_t displayFirstPage = 0;       // First page of the display window (host builds display controller).
+    uint8_t displayLastPage = (SCREEN_HEIGHT >> 3) - 1; // Last page of the display window (host builds display controller).
+    uint8_t displayColumn = 0;          // Column of the display cursor : the next byte sent is written there (host builds display controller).
+    uint8_t displayPage = 0;            // Page of the display cursor (host builds display controller).
+#endif
+    uint8_t sliceCoverage[SCREEN_HEIGHT >> 3]; // Rows of the current ray column already rendered, one byte for each page. Used after a see-through block only.
+    bool coverageMasking = false;       // Tells if the current ray went through a see-through block : the slices are then only rendered in the rows not covered yet.
+    uint8_t sliceTopY[RAY_COUNT];       // Y position of the first row covered by the slice of each ray (screen coordinates). Used for the ceiling rendering.
+    uint8_t sliceBottomY[RAY_COUNT];    // Y position of the last row covered by the slice of each ray (screen coordinates). Used for the floor rendering.
+    
+    void adaptResolution();             // Adapt the resolution of the 3D views to the measured render time.
+    void drawMap();                     // Draw the visible part of the world map and the player for the 2D views.
+    bool drawWallSlice(uint8_t rayNumber, uint16_t rayLength, uint8_t blockType, uint8_t blockHitOffset, bool horizontalHit, uint8_t lightLevel, bool transparent, int16_t *coverageTopY); // Render the slice of a block hit by a ray.
+    void fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2); // Fill a triangle given with MAP_SUBPIXEL_BITS fractional bits.
+    int32_t getEdgeX(int16_t topX, int16_t topY, int16_t bottomX, int16_t bottomY, int16_t row, int32_t *step); // Get the X position of a triangle edge on a given row.
+    void drawMinimap();                 // Draw the minimap, the player and its heading over a 3D view.
+    void drawPlayer(bool color);        // Draw the player as a 2 x 2 pixels square on the 2D views.
+    void drawPixel(int16_t x, int16_t y, bool color); // Write a pixel into the render target. Pixels outside of the screen are ignored.
+    void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1); // Draw a line into the render target (Bresenham algorithm).
+    void displayDirtyPages();           // Send only the screen buffer pages drawn in this frame or in the last one to the display.
+    void setDisplayWindow(uint8_t firstColumn, uint8_t lastColumn, uint8_t firstPage, uint8_t lastPage); // Set the display window written by the next data bytes.
+    void sendScreenBytes(uint8_t *bytes, uint16_t count); // Send bytes of the screen buffer to the display.
+#ifdef ARCE_HOST
+    void writeDisplayByte(uint8_t value); // Write a byte at the display cursor of the display memory, and move the cursor in the display window (host builds).
+#endif
+    void drawTexturedSlice(const uint8_t *texture, uint8_t blockHitOffset, uint8_t projectedSliceX, int16_t projectedSliceY, uint16_t projectedSliceHeight, 
+                           uint16_t projectedSliceRenderStartY, uint16_t projectedSliceRenderStopY, uint8_t shadeBand); // Render a textured slice.
+    void drawRleTexturedSlice(const uint8_t *texels, uint8_t textureSliceX, uint16_t textureSliceRenderStepByK, uint8_t projectedSliceX, int16_t projectedSliceY, 
+                              uint16_t projectedSliceRenderStartY, uint16_t projectedSliceRenderStopY, uint8_t shadeBand); // Render a slice of an RLE texture, run by run.
+    void drawSliceSpan(uint8_t projectedSliceX, uint8_t startY, uint8_t stopY, uint8_t pixels, uint8_t shadeBand);    // Write a solid span of a slice into the screen buffer.
+    void drawSliceByte(uint8_t projectedSliceX, uint8_t *page, uint8_t spanMask, uint8_t pixels, uint8_t shadeBand); // Write the pixels of a slice into a screen buffer byte.
+    void castFloorAndCeiling();         // Render the floor and the ceiling of a 3D view, row by row, around the slices rendered by castRay().
+    uint8_t getSurfaceTexel(uint8_t surfaceMode, const uint8_t *texture, uint8_t textureWidthShift, uint8_t textureHeightShift, uint16_t pointX, uint16_t pointY); // Read the floor or ceiling pixel at a given point of the world.
+    uint16_t getTextureLevelSize(uint8_t widthShift, uint8_t heightShift); // Get the size of a texture level (bytes) from its width and height expressed as powers of 2.
+    int16_t getCosBy128(int16_t angle); // Get the signed cosinus of any angle, multiplied by 128.
+    void setQueryOrigin(int16_t originX, int16_t originY); // Set up the origin of the next queries : its cell and the position of the cell in the world map.
+    bool traceQuery(ARCERayQuery *query); // Find the first block between the origin set up with setQueryOrigin() and the target of a query.
+    uint16_t getSquareRoot(uint32_t value); // Get the integer square root of a value.
 };
 
 #endif
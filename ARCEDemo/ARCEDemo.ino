@@ -53,138 +53,31 @@
 #include <stdio.h>
 #include <Arduboy.h>
 #include "ARCE.h"
+#include "ARCEDemoAssets.h"
 
-// Create a wall texture
-PROGMEM const uint8_t wall1[] = {
-  
-  B01111111,B11111101,B11111101,B11110111,
-  B01111111,B11111101,B11111101,B11110111,
-  B01111111,B11111101,B11111101,B11110111,
-  B01111111,B11111101,B11111101,B11110000,
-  B01111111,B11111101,B11111101,B11110111,
-  B01111111,B11111101,B11111101,B11110111,
-  B01111111,B11111101,B11111101,B11110111,
-  B00000000,B00000000,B00000001,B11110000,
-  B11111110,B11111111,B10111101,B11110111,
-  B11111110,B11111111,B10111101,B11110111,
-  B11111110,B11111111,B10111101,B11110111,
-  B11111110,B11111111,B10000001,B11110111,
-  B11111110,B11111111,B10111101,B11110111,
-  B11111110,B11111111,B10111101,B11110111,
-  B11111110,B11111111,B10111101,B11110111,
-  B11111110,B11111111,B10111101,B11110111,
-  B11111110,B11111111,B10111101,B11110111,
-  B11111110,B00000000,B00111101,B11110111,
-  B11111110,B11111111,B10111101,B11110111,
-  B11111110,B11111111,B10111101,B11110111,
-  B11111110,B11111111,B10111101,B11110111,
-  B00000000,B00000000,B00000000,B00000000,
-  B01111111,B11110111,B01111101,B11111111,
-  B01111111,B11110111,B01111101,B11111111,
-  B01111111,B11110111,B01111101,B11111111,
-  B01111111,B11110000,B00000001,B11111111,
-  B01111111,B11110111,B11111101,B11111111,
-  B01111111,B11110111,B11111101,B11111111,
-  B01111111,B11110111,B11111101,B11111111,
-  B01111111,B11110111,B11111101,B11111111,
-  B01111111,B11110111,B11111101,B11111111,
-  B01111111,B11110111,B11111101,B11111111
-};
+// Uncomment the DEMO_HUD line in order to render the 3D views above a HUD strip showing the player position. The rows of the HUD strip are not 
+// rendered by the engine (see ARCE::setViewport()).
+// #define DEMO_HUD
+#define DEMO_HUD_HEIGHT 8 // Height of the HUD strip at the bottom of the screen (screen coordinates).
 
-// Create a second wall texture
-PROGMEM const uint8_t wall2[] = {
-  
-  B01111111,B11111101,B11111101,B11110111,
-  B01111111,B11111101,B11111101,B11110111,
-  B01111111,B11111101,B11111101,B11110111,
-  B01111111,B11111101,B11111101,B11110000,
-  B01111111,B11111101,B11111101,B11110111,
-  B01111000,B00000000,B00000000,B00010111,
-  B01111011,B11111111,B11111111,B10010111,
-  B00000010,B01001001,B00100100,B10010000,
-  B11111010,B01001001,B00100100,B10010111,
-  B11111010,B01001001,B00100100,B11010111,
-  B11111010,B01001001,B00100100,B11010111,
-  B11111010,B01001001,B00100100,B11010111,
-  B11111010,B01001001,B00100100,B11010111,
-  B11111010,B01001001,B00100100,B10010111,
-  B11111011,B11101001,B00100100,B10010111,
-  B11111011,B11101001,B00100100,B10010111,
-  B11111011,B11101001,B00100100,B10010111,
-  B11111011,B11101001,B00100100,B10010111,
-  B11111010,B01101001,B00100100,B10010111,
-  B11111010,B01101001,B00100100,B10010111,
-  B11111011,B11101001,B00100100,B10010111,
-  B00000011,B11101001,B00100100,B10000000,
-  B01111011,B11101001,B00100100,B10011111,
-  B01111011,B11101001,B00100100,B10011111,
-  B01111010,B01001001,B00100100,B10011111,
-  B01111010,B01001001,B00100100,B11011111,
-  B01111010,B01001001,B00100100,B11011111,
-  B01111010,B01001001,B00100100,B11011111,
-  B01111010,B01001001,B00100100,B11011111,
-  B01111010,B01001001,B00100100,B10011111,
-  B01111010,B01001001,B00100100,B10011111,
-  B01111011,B11111111,B11111111,B10011111
-};
+// Uncomment the DEMO_REPLAY line in order to play the replay sessions of ARCEDemoReplay.h instead of reading the buttons. Each frame is checked 
+// against its golden hash and against the render time budget, and the result of each session is shown at its end. Uncomment the DEMO_REPLAY_CAPTURE
+// line too in order to print the hashes of the played frames over Serial : they are the new golden hashes after an intended change of the rendering.
+// #define DEMO_REPLAY
+// #define DEMO_REPLAY_CAPTURE
+#define DEMO_REPLAY_BUDGET_MICROS 50000 // Render time budget of a replayed frame (microseconds).
+#define DEMO_REPLAY_MAX_FRAMES 96       // Maximum number of frames of a replay session captured with DEMO_REPLAY_CAPTURE.
 
-// Create a door texture
-PROGMEM const uint8_t door[] = {
-  
-  B00000000,B00000000,B00000000,B00000000,
-  B01111111,B11111111,B11111111,B11111110,
-  B01011011,B01101101,B10110110,B11011010,
-  B01111111,B11111111,B11111111,B11111110,
-  B01110000,B00000000,B00000000,B00001110,
-  B01010111,B11111111,B11111111,B11101010,
-  B01110111,B11111111,B11111111,B11101110,
-  B01110111,B11111111,B11111111,B11101110,
-  B01010111,B11111111,B11111111,B11101010,
-  B01110111,B11111111,B11111111,B11101110,
-  B01110111,B11111111,B11111111,B11101110,
-  B01010111,B11111111,B11111111,B11101010,
-  B01110111,B00000011,B11111111,B11101110,
-  B01110101,B01111011,B11111111,B11101110,
-  B01010101,B01111011,B11111111,B11101010,
-  B01110101,B01001011,B11111111,B11101110,
-  B01110101,B01001011,B11111111,B11101110,
-  B01010101,B01111011,B11111111,B11101010,
-  B01110101,B01111011,B11111111,B11101110,
-  B01110111,B00000011,B11111111,B11101110,
-  B01010111,B11111111,B11111111,B11101010,
-  B01110111,B11111111,B11111111,B11101110,
-  B01110111,B11111111,B11111111,B11101110,
-  B01010111,B11111111,B11111111,B11101010,
-  B01110111,B11111111,B11111111,B11101110,
-  B01110111,B11111111,B11111111,B11101110,
-  B01010111,B11111111,B11111111,B11101010,
-  B01110000,B00000000,B00000000,B00001110,
-  B01111111,B11111111,B11111111,B11111110,
-  B01011011,B01101101,B10110110,B11011010,
-  B01111111,B11111111,B11111111,B11111110,
-  B00000000,B00000000,B00000000,B00000000
-};
+#ifdef DEMO_REPLAY
+#include "ARCEDemoReplay.h"
 
-// Create a 32 x 16 demo map
-PROGMEM const uint8_t demoMap[512] = {
-  
-  1,1,1,1,1,1,1,1,1,1,1,1,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-  2,0,0,0,1,0,0,0,1,0,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-  1,0,0,0,1,0,0,0,1,0,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-  1,0,0,0,1,0,0,0,1,0,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-  2,0,0,0,1,0,0,0,1,0,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-  1,0,0,0,1,1,0,1,1,1,1,0,1,1,1,1,1,1,1,3,1,1,1,1,1,1,0,0,0,0,0,0,
-  1,0,0,0,0,0,0,0,0,0,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,1,0,0,0,0,0,0,
-  2,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,3,0,0,0,0,0,0,
-  1,0,0,0,0,0,0,0,0,0,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,1,0,0,0,0,0,0,
-  1,0,0,0,1,1,0,1,1,1,1,1,1,1,1,1,1,1,1,3,1,1,1,1,1,1,0,0,0,0,0,0,
-  2,0,0,0,1,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-  1,0,0,0,1,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-  1,0,0,0,1,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-  2,0,0,0,1,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-  1,1,1,1,1,1,1,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
-};
+// Replay object and current replay session
+ARCEReplay replay;
+uint8_t replaySession = 0;
+#ifdef DEMO_REPLAY_CAPTURE
+uint16_t replayFrameHashes[DEMO_REPLAY_MAX_FRAMES];
+#endif
+#endif
 
 // Create the ARCE object
 ARCE arce;
@@ -198,6 +91,103 @@ uint32_t time = 0;
 uint32_t previousTime = 0;
 uint8_t fps = 0;
 
+// Strings for displaying FPS and player rotation angle
+char fpsText[4];
+char rotText[7];
+
+// Texts shown on the screen : a text is only drawn again when it changes
+char shownFps[4] = "";
+char shownRot[7] = "";
+char shownKey[10] = "";
+char shownView[15] = "";
+
+// Player position, rotation and view of the rendered frame : the view is only rendered again when they change
+int16_t renderedX = 0;
+int16_t renderedY = 0;
+int16_t renderedRot = 0;
+uint8_t renderedView = 0;
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Draw a text when it is not the text shown at this place. The shown text is erased first, and the pages of the text are marked for the dirty 
+// tracking : the texts which did not change are not sent to the display again.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+void drawText(uint8_t x, uint8_t y, const char *text, char *shownText) {
+  
+  if (!strcmp(text, shownText)) return;
+  
+  arce.display.fillRect(x, y, strlen(shownText) * 6, 8, 0);
+  arce.display.setCursor(x, y);
+  arce.display.print(text);
+  strcpy(shownText, text);
+  
+  arce.markDirty(y >> DIVIDE_BY_8);
+  arce.markDirty((y + 7) >> DIVIDE_BY_8);
+}
+
+#ifdef DEMO_REPLAY
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Load the world map, the player start and the view of the current replay session, and play it
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+void startReplaySession() {
+  
+  const DemoReplaySession *current = &replaySessions[replaySession]; // Current replay session.
+  
+  arce.loadWorldMap(current->worldMap, current->worldMapWidth, current->worldMapHeight);
+  arce.player.x = current->playerX;
+  arce.player.y = current->playerY;
+  arce.player.rot = current->playerRot;
+  arce.view = current->view;
+  
+#ifdef DEMO_REPLAY_CAPTURE
+  replay.frameHashes = replayFrameHashes;
+  replay.frameHashesSize = DEMO_REPLAY_MAX_FRAMES;
+  replay.play(current->session, current->sessionSize, 0);
+#else
+  replay.renderBudgetMicros = DEMO_REPLAY_BUDGET_MICROS;
+  replay.play(current->session, current->sessionSize, current->goldenHashes);
+#endif
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Show the result of the ended replay session, then play the next one
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+void endReplaySession() {
+  
+#ifdef DEMO_REPLAY_CAPTURE
+  replay.printSession();
+#endif
+  
+  arce.display.clearDisplay();
+  arce.display.setCursor(0, 0);
+  arce.display.print(F("Session "));
+  arce.display.print(replaySession + 1);
+  arce.display.print(replay.passed() ? F(" passed") : F(" failed"));
+  arce.display.setCursor(0, 10);
+  arce.display.print(F("Bad frames "));
+  arce.display.print(replay.failedFrames);
+  if (replay.failedFrames) {
+    
+    arce.display.print(F(" from "));
+    arce.display.print(replay.firstFailedFrame);
+  }
+  arce.display.setCursor(0, 20);
+  arce.display.print(F("Over budget "));
+  arce.display.print(replay.overBudgetFrames);
+  arce.display.setCursor(0, 30);
+  arce.display.print(F("Max us "));
+  arce.display.print(replay.maxRenderMicros);
+  arce.display.setCursor(0, 40);
+  arce.display.print(F("Mean us "));
+  arce.display.print(replay.frame ? replay.totalRenderMicros / replay.frame : 0);
+  arce.markDirty(DIRTY_ALL_PAGES);
+  arce.displayFrame();
+  delay(3000);
+  
+  replaySession = (replaySession + 1) % (sizeof(replaySessions) / sizeof(DemoReplaySession));
+  startReplaySession();
+}
+#endif
+
 // ------------------------------------------------------------------------------------------------------------------------------------------------------
 // Arduino setup function
 // ------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -205,6 +195,14 @@ void setup() {
   
   // Initialize ARCE
   arce.start();
+  arce.clearAfterDisplay = true;
+  arce.dirtyTracking = true;
+  arce.display.clearDisplay();
+  
+#ifdef ARCE_PROFILE
+  // The engine statistics are sent to the serial monitor
+  Serial.begin(9600);
+#endif
   
   // Load the 32 x 16 demo map
   arce.loadWorldMap(demoMap, 32, 16);
@@ -213,11 +211,36 @@ void setup() {
   arce.texturesArray[0] = wall1; // texturesArray[0] is used with block "1" in world map
   arce.texturesArray[1] = wall2; // texturesArray[1] is used with block "2" in world map
   arce.texturesArray[2] = door;  // texturesArray[2] is used with block "3" in world map
+
+  // Render a checkerboard floor in 3D views
+  arce.floorMode = SURFACE_CHECKERBOARD;
+  
+  // Draw a minimap at the top of the 3D views, between the view name (up to 66 pixels wide) and the FPS counter (from X = 100)
+  arce.minimap = true;
+  arce.minimapX = 68;
+  
+  // Lower the 3D views resolution when a frame is too slow to render
+  arce.resolution = RESOLUTION_ADAPTIVE;
   
   // Initialize player position and rotation
   arce.player.x = 416;
   arce.player.y = 192;
   arce.player.rot = 90;
+  
+#ifdef DEMO_HUD
+  // The 3D views are rendered above the HUD strip
+  arce.setViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT - DEMO_HUD_HEIGHT);
+#endif
+  
+#ifdef DEMO_REPLAY
+  // The replayed frames must not depend on the render time
+  arce.resolution = RESOLUTION_HIGH;
+  arce.replay = &replay;
+#ifdef DEMO_REPLAY_CAPTURE
+  Serial.begin(9600);
+#endif
+  startReplaySession();
+#endif
 }
 
 // ------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -229,9 +252,10 @@ void loop() {
   sprintf(view, "");
   sprintf(key, "");
   
-  // Clear display
-  arce.display.clearDisplay();
-  
+#ifdef DEMO_REPLAY
+  // The buttons are not read while a replay session is played
+  if (replay.mode == REPLAY_DONE) endReplaySession();
+#else
   // Read keys
   if(arce.display.pressed(UP_BUTTON)) {
     
@@ -291,29 +315,77 @@ void loop() {
     sprintf(key, "B");
     arce.player.rotDir = PLAYER_ROTATE_RIGHT;
   }
+#endif
     
-  // Update ARCE (Player movement and rotation, etc...)
-  arce.update();
+  // Run ARCE simulation at a fixed rate (Player movement and rotation, etc...). The frame is skipped when the simulation is behind.
+  if (!arce.step()) return;
+  
+  // The view is only rendered when the player moved or turned, when the view changed, or when the screen buffer was cleared by the last 
+  // displayFrame() call. A frame is only cleared while it is sent when the player moves : an idle frame keeps the rendered view in the screen buffer,
+  // so only the texts which change are drawn and sent to the display.
+#ifdef DEMO_REPLAY
+  bool moved = true; // Each replayed frame is rendered and checked
+#else
+  bool moved = arce.player.x != renderedX || arce.player.y != renderedY || arce.player.rot != renderedRot || arce.view != renderedView;
+#endif
+  
+  if (moved || arce.clearAfterDisplay) {
+    
+    // A kept frame is cleared before the render : all its pages change
+    if (!arce.clearAfterDisplay) {
+      
+      arce.display.clearDisplay();
+      arce.markDirty(DIRTY_ALL_PAGES);
+    }
+    
+    // Render ARCE view
+    arce.render();
+    renderedX = arce.player.x;
+    renderedY = arce.player.y;
+    renderedRot = arce.player.rot;
+    renderedView = arce.view;
+    
+    // The texts are drawn again over the new frame
+    shownFps[0] = 0;
+    shownRot[0] = 0;
+    shownKey[0] = 0;
+    shownView[0] = 0;
+    
+#ifdef DEMO_HUD
+    // Draw the HUD strip : a separator line and the player position (blocks)
+    arce.display.fillRect(0, SCREEN_HEIGHT - DEMO_HUD_HEIGHT, SCREEN_WIDTH, DEMO_HUD_HEIGHT, 0);
+    arce.display.drawFastHLine(0, SCREEN_HEIGHT - DEMO_HUD_HEIGHT, SCREEN_WIDTH, 1);
+    arce.display.setCursor(0, SCREEN_HEIGHT - DEMO_HUD_HEIGHT + 1);
+    arce.display.print(arce.player.x >> DIVIDE_BY_BLOCK_SIZE);
+    arce.display.print(F(","));
+    arce.display.print(arce.player.y >> DIVIDE_BY_BLOCK_SIZE);
+    arce.markDirty((SCREEN_HEIGHT - DEMO_HUD_HEIGHT) >> DIVIDE_BY_8);
+#endif
+  }
+  arce.clearAfterDisplay = moved;
   
   // Show FPS (for debug only) 
   time = millis();
   fps = 1000.0f / (time - previousTime);
-  arce.display.setCursor(100, 0);
-  arce.display.print(fps); 
+  sprintf(fpsText, "%d", fps);
+  drawText(100, 0, fpsText, shownFps);
   previousTime = time;
   
   // Show current player rotation angle
-  arce.display.setCursor(100, 10);
-  arce.display.print(arce.player.rot);
+  sprintf(rotText, "%d", arce.player.rot);
+  drawText(100, 10, rotText, shownRot);
   
   // Show current key
-  arce.display.setCursor(100, 20);
-  arce.display.print(key);
+  drawText(100, 20, key, shownKey);
   
   // Show current view  
-  arce.display.setCursor(0, 0);
-  arce.display.print(view);
+  drawText(0, 0, view, shownView);
 
   // Update Display
-  arce.display.display();
-}
+  arce.displayFrame();
+  
+#ifdef ARCE_PROFILE
+  // Send the engine statistics of the frame to the serial monitor
+  arce.printStats();
+#endif
+}
@@ -0,0 +1,290 @@
+//
+// ARCE demo assets
+//
+// Copyright (C) 2015 Jerome Perrot (Initgraph)
+//
+// Notes :
+//
+//   Textures and world map of the ARCE demo (ARCEDemo.ino). They are kept in this header so the programs which build the engine on a computer
+//   (see tools/ARCECheck) render the same frames as the demo.
+//
+// Licence :
+//
+//   This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by
+//   the Free Software Foundation; either version 2 of the License, or (at your option) any later version.
+//   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc.,
+//   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+
+#ifndef ARCE_DEMO_ASSETS_H
+#define ARCE_DEMO_ASSETS_H
+
+// Create a wall texture
+PROGMEM const uint8_t wall1[] = {
+  
+  // Descriptor : 32 x 32 texels, row-major, 4 levels of detail
+  TEXTURE_SIZE_32, TEXTURE_SIZE_32, TEXTURE_FORMAT_ROW_MAJOR, 4,
+  
+  0b01111111,0b11111101,0b11111101,0b11110111,
+  0b01111111,0b11111101,0b11111101,0b11110111,
+  0b01111111,0b11111101,0b11111101,0b11110111,
+  0b01111111,0b11111101,0b11111101,0b11110000,
+  0b01111111,0b11111101,0b11111101,0b11110111,
+  0b01111111,0b11111101,0b11111101,0b11110111,
+  0b01111111,0b11111101,0b11111101,0b11110111,
+  0b00000000,0b00000000,0b00000001,0b11110000,
+  0b11111110,0b11111111,0b10111101,0b11110111,
+  0b11111110,0b11111111,0b10111101,0b11110111,
+  0b11111110,0b11111111,0b10111101,0b11110111,
+  0b11111110,0b11111111,0b10000001,0b11110111,
+  0b11111110,0b11111111,0b10111101,0b11110111,
+  0b11111110,0b11111111,0b10111101,0b11110111,
+  0b11111110,0b11111111,0b10111101,0b11110111,
+  0b11111110,0b11111111,0b10111101,0b11110111,
+  0b11111110,0b11111111,0b10111101,0b11110111,
+  0b11111110,0b00000000,0b00111101,0b11110111,
+  0b11111110,0b11111111,0b10111101,0b11110111,
+  0b11111110,0b11111111,0b10111101,0b11110111,
+  0b11111110,0b11111111,0b10111101,0b11110111,
+  0b00000000,0b00000000,0b00000000,0b00000000,
+  0b01111111,0b11110111,0b01111101,0b11111111,
+  0b01111111,0b11110111,0b01111101,0b11111111,
+  0b01111111,0b11110111,0b01111101,0b11111111,
+  0b01111111,0b11110000,0b00000001,0b11111111,
+  0b01111111,0b11110111,0b11111101,0b11111111,
+  0b01111111,0b11110111,0b11111101,0b11111111,
+  0b01111111,0b11110111,0b11111101,0b11111111,
+  0b01111111,0b11110111,0b11111101,0b11111111,
+  0b01111111,0b11110111,0b11111101,0b11111111,
+  0b01111111,0b11110111,0b11111101,0b11111111,
+  
+  // Level of detail 1 (16 x 16)
+  0b01111110,0b11101101,
+  0b01111110,0b11101100,
+  0b01111110,0b11101101,
+  0b00000000,0b00001100,
+  0b11101111,0b01101101,
+  0b11101111,0b00001101,
+  0b11101111,0b01101101,
+  0b11101111,0b01101101,
+  0b11100000,0b01101101,
+  0b11101111,0b01101101,
+  0b00000000,0b00000000,
+  0b01111101,0b01101111,
+  0b01111100,0b00001111,
+  0b01111101,0b11101111,
+  0b01111101,0b11101111,
+  0b01111101,0b11101111,
+  
+  // Level of detail 2 (8 x 8)
+  0b11111111,
+  0b11111111,
+  0b11111111,
+  0b11111111,
+  0b11111111,
+  0b11111111,
+  0b11111111,
+  0b11111111,
+  
+  // Level of detail 3 (4 x 4)
+  0b11111111,0b11111111,
+  
+  // Level of detail 4 (average texel)
+  0b11111111
+};
+
+// Create a second wall texture
+PROGMEM const uint8_t wall2[] = {
+  
+  // Descriptor : 32 x 32 texels, RLE, 4 levels of detail
+  TEXTURE_SIZE_32, TEXTURE_SIZE_32, TEXTURE_FORMAT_RLE, 4,
+  
+  // Column offsets
+  TEXTURE_RLE_OFFSET(66), TEXTURE_RLE_OFFSET(69), TEXTURE_RLE_OFFSET(74), TEXTURE_RLE_OFFSET(79), TEXTURE_RLE_OFFSET(84), TEXTURE_RLE_OFFSET(89), TEXTURE_RLE_OFFSET(91), TEXTURE_RLE_OFFSET(94),
+  TEXTURE_RLE_OFFSET(103), TEXTURE_RLE_OFFSET(112), TEXTURE_RLE_OFFSET(115), TEXTURE_RLE_OFFSET(122), TEXTURE_RLE_OFFSET(127), TEXTURE_RLE_OFFSET(130), TEXTURE_RLE_OFFSET(135), TEXTURE_RLE_OFFSET(139),
+  TEXTURE_RLE_OFFSET(142), TEXTURE_RLE_OFFSET(147), TEXTURE_RLE_OFFSET(152), TEXTURE_RLE_OFFSET(155), TEXTURE_RLE_OFFSET(160), TEXTURE_RLE_OFFSET(165), TEXTURE_RLE_OFFSET(168), TEXTURE_RLE_OFFSET(172),
+  TEXTURE_RLE_OFFSET(177), TEXTURE_RLE_OFFSET(180), TEXTURE_RLE_OFFSET(186), TEXTURE_RLE_OFFSET(188), TEXTURE_RLE_OFFSET(191), TEXTURE_RLE_OFFSET(193), TEXTURE_RLE_OFFSET(200), TEXTURE_RLE_OFFSET(207),
+  TEXTURE_RLE_OFFSET(214),
+  // Column runs
+  0b00001000,0b10001101,0b00001011,
+  0b10000111,0b00000001,0b10001101,0b00000001,0b10001010,
+  0b10000111,0b00000001,0b10001101,0b00000001,0b10001010,
+  0b10000111,0b00000001,0b10001101,0b00000001,0b10001010,
+  0b10000111,0b00000001,0b10001101,0b00000001,0b10001010,
+  0b10000101,0b00011011,
+  0b10000101,0b00000001,0b10011010,
+  0b10000101,0b00000001,0b10000001,0b00000111,0b10000100,0b00000010,0b10000100,0b00000111,0b10000001,
+  0b10000101,0b00000001,0b10000001,0b00000111,0b10000100,0b00000010,0b10000100,0b00000111,0b10000001,
+  0b10000101,0b00000001,0b10011010,
+  0b10000101,0b00000001,0b10000001,0b00000111,0b10001010,0b00000111,0b10000001,
+  0b10000101,0b00000001,0b10000001,0b00011000,0b10000001,
+  0b10000101,0b00000001,0b10011010,
+  0b10000101,0b00000001,0b10000001,0b00011000,0b10000001,
+  0b00000110,0b10000001,0b00011000,0b10000001,
+  0b10000101,0b00000001,0b10011010,
+  0b10000101,0b00000001,0b10000001,0b00011000,0b10000001,
+  0b10000101,0b00000001,0b10000001,0b00011000,0b10000001,
+  0b10000101,0b00000001,0b10011010,
+  0b10000101,0b00000001,0b10000001,0b00011000,0b10000001,
+  0b10000101,0b00000001,0b10000001,0b00011000,0b10000001,
+  0b10000101,0b00000001,0b10011010,
+  0b00000110,0b10000001,0b00011000,0b10000001,
+  0b10000101,0b00000001,0b10000001,0b00011000,0b10000001,
+  0b10000101,0b00000001,0b10011010,
+  0b10000101,0b00000100,0b10000100,0b00001100,0b10000100,0b00000011,
+  0b10000101,0b00011011,
+  0b10010101,0b00000001,0b10001010,
+  0b00010110,0b10001010,
+  0b10000011,0b00000001,0b10000011,0b00000001,0b10001101,0b00000001,0b10001010,
+  0b10000011,0b00000001,0b10000011,0b00000001,0b10001101,0b00000001,0b10001010,
+  0b10000011,0b00000001,0b10000011,0b00000001,0b10001101,0b00000001,0b10001010,
+  
+  // Level of detail 1 (16 x 16)
+  // Column offsets
+  TEXTURE_RLE_OFFSET(34), TEXTURE_RLE_OFFSET(37), TEXTURE_RLE_OFFSET(42), TEXTURE_RLE_OFFSET(44), TEXTURE_RLE_OFFSET(53), TEXTURE_RLE_OFFSET(62), TEXTURE_RLE_OFFSET(64), TEXTURE_RLE_OFFSET(69),
+  TEXTURE_RLE_OFFSET(73), TEXTURE_RLE_OFFSET(75), TEXTURE_RLE_OFFSET(80), TEXTURE_RLE_OFFSET(85), TEXTURE_RLE_OFFSET(86), TEXTURE_RLE_OFFSET(92), TEXTURE_RLE_OFFSET(94), TEXTURE_RLE_OFFSET(96),
+  TEXTURE_RLE_OFFSET(103),
+  // Column runs
+  0b00000100,0b10000110,0b00000110,
+  0b10000011,0b00000001,0b10000110,0b00000001,0b10000101,
+  0b10000011,0b00001101,
+  0b10000010,0b00000001,0b10000001,0b00000011,0b10000010,0b00000001,0b10000010,0b00000011,0b10000001,
+  0b10000010,0b00000001,0b10000001,0b00000011,0b10000010,0b00000001,0b10000010,0b00000011,0b10000001,
+  0b10000010,0b00001110,
+  0b10000010,0b00000001,0b10000001,0b00001011,0b10000001,
+  0b00000011,0b10000001,0b00001011,0b10000001,
+  0b10000010,0b00001110,
+  0b10000010,0b00000001,0b10000001,0b00001011,0b10000001,
+  0b10000010,0b00000001,0b10000001,0b00001011,0b10000001,
+  0b00010000,
+  0b10000010,0b00000010,0b10000011,0b00000101,0b10000011,0b00000001,
+  0b10000011,0b00001101,
+  0b00001011,0b10000101,
+  0b10000001,0b00000001,0b10000001,0b00000001,0b10000110,0b00000001,0b10000101,
+  
+  // Level of detail 2 (8 x 8)
+  // Column offsets
+  TEXTURE_RLE_OFFSET(18), TEXTURE_RLE_OFFSET(19), TEXTURE_RLE_OFFSET(24), TEXTURE_RLE_OFFSET(28), TEXTURE_RLE_OFFSET(31), TEXTURE_RLE_OFFSET(33), TEXTURE_RLE_OFFSET(35), TEXTURE_RLE_OFFSET(38),
+  TEXTURE_RLE_OFFSET(39),
+  // Column runs
+  0b10001000,
+  0b10000010,0b00000001,0b10000011,0b00000001,0b10000001,
+  0b10000010,0b00000010,0b10000010,0b00000010,
+  0b10000010,0b00000101,0b10000001,
+  0b10000010,0b00000110,
+  0b10000001,0b00000111,
+  0b10000100,0b00000010,0b10000010,
+  0b10001000,
+  
+  // Level of detail 3 (4 x 4)
+  // Column offsets
+  TEXTURE_RLE_OFFSET(10), TEXTURE_RLE_OFFSET(11), TEXTURE_RLE_OFFSET(15), TEXTURE_RLE_OFFSET(17), TEXTURE_RLE_OFFSET(18),
+  // Column runs
+  0b10000100,
+  0b10000001,0b00000001,0b10000001,0b00000001,
+  0b10000001,0b00000011,
+  0b10000100,
+  
+  // Level of detail 4 (average texel)
+  0b11111111
+};
+
+// Create a door texture
+PROGMEM const uint8_t door[] = {
+  
+  // Descriptor : 32 x 32 texels, row-major, 4 levels of detail
+  TEXTURE_SIZE_32, TEXTURE_SIZE_32, TEXTURE_FORMAT_ROW_MAJOR, 4,
+  
+  0b00000000,0b00000000,0b00000000,0b00000000,
+  0b01111111,0b11111111,0b11111111,0b11111110,
+  0b01011011,0b01101101,0b10110110,0b11011010,
+  0b01111111,0b11111111,0b11111111,0b11111110,
+  0b01110000,0b00000000,0b00000000,0b00001110,
+  0b01010111,0b11111111,0b11111111,0b11101010,
+  0b01110111,0b11111111,0b11111111,0b11101110,
+  0b01110111,0b11111111,0b11111111,0b11101110,
+  0b01010111,0b11111111,0b11111111,0b11101010,
+  0b01110111,0b11111111,0b11111111,0b11101110,
+  0b01110111,0b11111111,0b11111111,0b11101110,
+  0b01010111,0b11111111,0b11111111,0b11101010,
+  0b01110111,0b00000011,0b11111111,0b11101110,
+  0b01110101,0b01111011,0b11111111,0b11101110,
+  0b01010101,0b01111011,0b11111111,0b11101010,
+  0b01110101,0b01001011,0b11111111,0b11101110,
+  0b01110101,0b01001011,0b11111111,0b11101110,
+  0b01010101,0b01111011,0b11111111,0b11101010,
+  0b01110101,0b01111011,0b11111111,0b11101110,
+  0b01110111,0b00000011,0b11111111,0b11101110,
+  0b01010111,0b11111111,0b11111111,0b11101010,
+  0b01110111,0b11111111,0b11111111,0b11101110,
+  0b01110111,0b11111111,0b11111111,0b11101110,
+  0b01010111,0b11111111,0b11111111,0b11101010,
+  0b01110111,0b11111111,0b11111111,0b11101110,
+  0b01110111,0b11111111,0b11111111,0b11101110,
+  0b01010111,0b11111111,0b11111111,0b11101010,
+  0b01110000,0b00000000,0b00000000,0b00001110,
+  0b01111111,0b11111111,0b11111111,0b11111110,
+  0b01011011,0b01101101,0b10110110,0b11011010,
+  0b01111111,0b11111111,0b11111111,0b11111110,
+  0b00000000,0b00000000,0b00000000,0b00000000,
+  
+  // Level of detail 1 (16 x 16)
+  0b00000000,0b00000000,
+  0b01111111,0b11111110,
+  0b01000000,0b00000010,
+  0b01011111,0b11111010,
+  0b01011111,0b11111010,
+  0b01011111,0b11111010,
+  0b01010001,0b11111010,
+  0b01000001,0b11111010,
+  0b01000001,0b11111010,
+  0b01010001,0b11111010,
+  0b01011111,0b11111010,
+  0b01011111,0b11111010,
+  0b01011111,0b11111010,
+  0b01000000,0b00000010,
+  0b01111111,0b11111110,
+  0b00000000,0b00000000,
+  
+  // Level of detail 2 (8 x 8)
+  0b01111110,
+  0b11111111,
+  0b11111111,
+  0b11011111,
+  0b11011111,
+  0b11111111,
+  0b11111111,
+  0b01111110,
+  
+  // Level of detail 3 (4 x 4)
+  0b11111111,0b11111111,
+  
+  // Level of detail 4 (average texel)
+  0b11111111
+};
+
+// Create a 32 x 16 demo map
+PROGMEM const uint8_t demoMap[512] = {
+  
+  1,1,1,1,1,1,1,1,1,1,1,1,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  2,0,0,0,1,0,0,0,1,0,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  1,0,0,0,1,0,0,0,1,0,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  1,0,0,0,1,0,0,0,1,0,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  2,0,0,0,1,0,0,0,1,0,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  1,0,0,0,1,1,0,1,1,1,1,0,1,1,1,1,1,1,1,3,1,1,1,1,1,1,0,0,0,0,0,0,
+  1,0,0,0,0,0,0,0,0,0,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,1,0,0,0,0,0,0,
+  2,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,3,0,0,0,0,0,0,
+  1,0,0,0,0,0,0,0,0,0,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,1,0,0,0,0,0,0,
+  1,0,0,0,1,1,0,1,1,1,1,1,1,1,1,1,1,1,1,3,1,1,1,1,1,1,0,0,0,0,0,0,
+  2,0,0,0,1,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  1,0,0,0,1,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  1,0,0,0,1,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  2,0,0,0,1,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  1,1,1,1,1,1,1,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
+};
+
+#endif
@@ -0,0 +1,106 @@
+//
+// ARCE demo replay sessions
+//
+// Copyright (C) 2015 Jerome Perrot (Initgraph)
+//
+// Notes :
+//
+//   Replay sessions of the ARCE demo (DEMO_REPLAY in ARCEDemo.ino), with the golden hash of each frame rendered by the engine. The sessions use the
+//   demo assets : ARCEDemoAssets.h must be included first. The golden hashes below were printed by ARCECheck --capture on a computer (see
+//   tools/ARCECheck), which checks them at each run, with the host integer widths and with the AVR ones (ARCEIntWidth.py). On the device, the demo
+//   built with DEMO_REPLAY_CAPTURE prints the hashes of its own frames, which must be the same.
+//
+// Licence :
+//
+//   This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by
+//   the Free Software Foundation; either version 2 of the License, or (at your option) any later version.
+//   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc.,
+//   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+
+#ifndef ARCE_DEMO_REPLAY_H
+#define ARCE_DEMO_REPLAY_H
+
+// Create a 8 x 8 map with pillars for the replay sessions
+PROGMEM const uint8_t pillarsMap[64] = {
+  
+  1,1,1,2,2,1,1,1,
+  1,0,0,0,0,0,0,1,
+  1,0,3,0,0,3,0,1,
+  2,0,0,0,0,0,0,2,
+  2,0,0,0,0,0,0,2,
+  1,0,3,0,0,3,0,1,
+  1,0,0,0,0,0,0,1,
+  1,1,1,2,2,1,1,1
+};
+
+// Replay session : walk along the demo map corridor and look around (textured 3D view)
+PROGMEM const uint8_t corridorSession[] = {
+  
+  REPLAY_RUN(PLAYER_MOVE_NONE, PLAYER_ROTATE_NONE, 1),
+  REPLAY_RUN(PLAYER_MOVE_FORWARD, PLAYER_ROTATE_NONE, 16),
+  REPLAY_RUN(PLAYER_MOVE_FORWARD, PLAYER_ROTATE_LEFT, 8),
+  REPLAY_RUN(PLAYER_MOVE_NONE, PLAYER_ROTATE_LEFT, 16),
+  REPLAY_RUN(PLAYER_MOVE_FORWARD, PLAYER_ROTATE_NONE, 12),
+  REPLAY_RUN(PLAYER_MOVE_BACKWARD, PLAYER_ROTATE_RIGHT, 10)
+};
+
+// Golden hashes of the corridor session
+PROGMEM const uint16_t corridorHashes[] = {
+  
+  0x0758,0xE010,0x9D64,0x7C85,0x85DC,0xCCE2,0xBA40,0x2E63,
+  0x545B,0x073E,0xE085,0xCE58,0x4994,0x6560,0x79E9,0x6C7B,
+  0x29A1,0xFCD7,0x1A7F,0x7C16,0x37E9,0xCE8D,0xA04F,0xA507,
+  0x1E9F,0xBE66,0x5A41,0x9BC1,0xFC03,0x3EC0,0xAEA9,0x2764,
+  0x430C,0x2E39,0x7ECC,0x6CE7,0x3215,0xB463,0x6E0B,0x99EE,
+  0xA4BC,0xFA36,0x1A3E,0x89C1,0xB049,0xE859,0x7FC7,0xE48E,
+  0x37E0,0x3FBD,0x8117,0xD437,0xC683,0x7647,0xEF20,0xCD7F,
+  0xD58C,0xEC73,0xE2AA,0xFB3B,0x3167,0x77BB,0x185C
+};
+
+// Replay session : turn around the pillars (solid 3D view)
+PROGMEM const uint8_t pillarsSession[] = {
+  
+  REPLAY_RUN(PLAYER_MOVE_NONE, PLAYER_ROTATE_RIGHT, 16),
+  REPLAY_RUN(PLAYER_MOVE_FORWARD, PLAYER_ROTATE_RIGHT, 16),
+  REPLAY_RUN(PLAYER_MOVE_FORWARD, PLAYER_ROTATE_NONE, 8),
+  REPLAY_RUN(PLAYER_MOVE_BACKWARD, PLAYER_ROTATE_LEFT, 12)
+};
+
+// Golden hashes of the pillars session
+PROGMEM const uint16_t pillarsHashes[] = {
+  
+  0x21C1,0x10B3,0x04A1,0xE14D,0xA0E4,0xB35E,0x7CE9,0xAEE6,
+  0xAF0A,0x5DF2,0x35C9,0x346B,0xA64E,0xFB19,0x1F7A,0x7FA4,
+  0xD9C9,0xB647,0x55CE,0x7AAA,0x35B2,0x58B5,0xD0D0,0x9655,
+  0xF603,0xC382,0xD4F9,0xDE8D,0xB583,0xB583,0x86F2,0xE48A,
+  0xE48A,0xE48A,0xE48A,0xE48A,0xE48A,0xE48A,0xE48A,0xE48A,
+  0x86F2,0xB8D4,0xDC4F,0x691D,0xE866,0xFF63,0x27C5,0xFEE5,
+  0x9A24,0xBB6D,0x74B5,0x4204
+};
+
+// Replay sessions : world map, player start and view of each session
+struct DemoReplaySession {
+  
+  const uint8_t *worldMap;      // World map of the session.
+  uint8_t worldMapWidth;        // World map width.
+  uint8_t worldMapHeight;       // World map height.
+  int16_t playerX;              // X position of the player at the session start (world coordinates).
+  int16_t playerY;              // Y position of the player at the session start (world coordinates).
+  int16_t playerRot;            // Rotation of the player at the session start (degrees).
+  uint8_t view;                 // View of the session.
+  const uint8_t *session;       // Player input of the session.
+  uint16_t sessionSize;         // Size of the session (bytes).
+  const uint16_t *goldenHashes; // Golden hash of each frame of the session.
+};
+
+const DemoReplaySession replaySessions[] = {
+  
+  { demoMap, 32, 16, 416, 192, 90, VIEW_3D_TEXTURED, corridorSession, sizeof(corridorSession), corridorHashes },
+  { pillarsMap, 8, 8, 256, 256, 0, VIEW_3D_SOLID, pillarsSession, sizeof(pillarsSession), pillarsHashes }
+};
+
+#endif
@@ -0,0 +1,1006 @@
+//
+// ARCEAssets : ARCE assets converter
+//
+// Copyright (C) 2015 Jerome Perrot (Initgraph)
+//
+// Notes :
+//
+//   ARCEAssets is a command-line program which runs on a computer, not on the Arduboy. It converts images and maps into the ARCE runtime formats,
+//   so the textures and the world maps no longer have to be written by hand and all the preprocessing (packing, run-length encoding, levels of
+//   detail, offsets) is done once, before the game is compiled. It builds the engine itself (ARCE.cpp) as a host build, so it shares the engine
+//   constants and code. Build it from this folder with any C++ compiler, for example :
+//
+//     g++ -O2 -DARCE_HOST -I../.. -o ARCEAssets ARCEAssets.cpp ../../ARCE.cpp
+//
+//   When the world map has light sources, the light received by each block face is baked into a light map (see ARCE::loadLightMap()). The light of
+//   a face is sampled at LIGHT_SAMPLES points along the face, and a light source only lights the points it sees : the occlusion is found with
+//   ARCE::castQuery(), the query the game uses for its lines of sight.
+//
+//   Usage :
+//
+//     ARCEAssets [options] --texture NAME=FILE.pbm ... --map NAME=FILE.csv [--header FILE.h] [--pack FILE.bin] [--pack-array NAME=FILE.h]
+//
+//   Inputs :
+//
+//     --texture NAME=FILE.pbm : a texture, read from a PBM image (P1 or P4). The first texture is used with the block "1" of the world map, the
+//                               second one with the block "2", etc... Black PBM pixels are black texels. Images in other formats (PNG...) can be
+//                               converted into PBM images with any image tool (netpbm, ImageMagick...).
+//     --format FORMAT         : packing format of the next textures : row, column, rle or auto (default). auto chooses RLE when it is smaller than
+//                               the column-major format, which means the texture is made of long vertical runs, and column-major otherwise.
+//     --lod COUNT             : number of levels of detail of the next textures : 0 to 15, or auto (default : down to 4 texels high).
+//     --mask FILE.pbm         : mask of the next texture (white pixels are transparent texels). Masked textures can't be RLE textures.
+//     --height HEIGHT         : height of the next block type, in world coordinates (default : BLOCK_SIZE).
+//     --map NAME=FILE.csv     : the world map, one row of blocks by line, the blocks separated with commas or spaces. A block is a block type
+//                               (0 = empty), a spawn point : S or S followed by the rotation of the player (degrees), for example S90, or a light
+//                               source : L or L followed by its radius (blocks), for example L4.
+//     --ambient PERCENT       : light received by all the block faces when the world map has light sources (default : 0).
+//     --border BLOCK          : surround the world map with blocks of a given type. The engine casts the rays of an enclosed world map (solid
+//                               border) with fewer tests, see ARCE::loadWorldMap().
+//
+//   Outputs :
+//
+//     --header FILE.h          : C++ header with the textures, the world map, the block heights, the spawn points and the light map as PROGMEM arrays.
+//     --pack FILE.bin          : level pack file (see the level pack section in ARCE.h), to be streamed or mapped in memory.
+//     --pack-array NAME=FILE.h : C++ header with the level pack as a PROGMEM array, to be loaded with ARCE::loadLevelPack().
+//
+// Licence :
+//
+//   This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by
+//   the Free Software Foundation; either version 2 of the License, or (at your option) any later version.
+//   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc.,
+//   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include "ARCE.h"
+
+#ifndef ARCE_HOST
+#error "ARCEAssets must be built with -DARCE_HOST"
+#endif
+
+// ARCE limits which are not ARCE.h constants. They must match the engine code.
+#define TEXTURE_MAX_LOD_COUNT 15       // Maximum number of levels of detail of a texture.
+#define TEXTURE_MIN_SIZE_SHIFT 3       // Smallest texture width or height (power of 2).
+#define TEXTURE_MAX_SIZE_SHIFT 6       // Biggest texture width or height (power of 2).
+#define LIGHT_LEVEL_COUNT 4            // Number of light levels of a face (0 = lit, 3 = darkest).
+
+// ARCEAssets constants
+#define FORMAT_AUTO 0xFF               // Packing format chosen from the texture content.
+#define LOD_AUTO 0xFF                  // Levels of detail down to 4 texels high.
+#define LOD_AUTO_MIN_SIZE_SHIFT 2      // Smallest level of detail of LOD_AUTO, except the average texel (power of 2).
+#define LIGHT_DEFAULT_RADIUS 6         // Radius of a light source without radius in the world map (blocks).
+#define LIGHT_SAMPLES 4                // Number of points sampled along a block face when the light map is baked.
+
+// Image : one byte for each pixel (1 = white texel or opaque mask texel).
+struct Image {
+
+  int width = 0;                       // Image width (pixels).
+  int height = 0;                      // Image height (pixels).
+  std::vector<uint8_t> pixels;         // Pixels, row by row.
+};
+
+// Texture to convert.
+struct Texture {
+
+  std::string name;                    // Name of the texture array.
+  std::string path;                    // Path of the texture image.
+  Image image;                         // Texture image.
+  Image mask;                          // Texture mask (masked textures only).
+  bool masked = false;                 // Tells if the texture has a mask.
+  uint8_t format = FORMAT_AUTO;        // Packing format (TEXTURE_FORMAT_... or FORMAT_AUTO).
+  uint8_t lodCount = LOD_AUTO;         // Number of levels of detail (or LOD_AUTO).
+  uint8_t height = BLOCK_SIZE;         // Height of the block type (world coordinates).
+  std::vector<uint8_t> bytes;          // Converted texture : descriptor, levels of detail and mask.
+};
+
+// World map to convert.
+struct WorldMap {
+
+  std::string name;                    // Name of the world map array.
+  std::string path;                    // Path of the world map file.
+  int width = 0;                       // World map width (blocks).
+  int height = 0;                      // World map height (blocks).
+  std::vector<uint8_t> blocks;         // Blocks, row by row.
+  std::vector<int16_t> spawns;         // Spawn points : X, Y (world coordinates) and rotation (degrees) of the player.
+  std::vector<int16_t> lights;         // Light sources : X, Y and radius (world coordinates).
+  std::vector<uint8_t> lightMap;       // Baked light map, one byte for each block (empty when the world map has no light source).
+};
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Read the next number of a PBM header, skipping the white spaces and the comments. Returns -1 at the end of the file.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+static int readPbmNumber(FILE *file) {
+
+  int c = 0;     // Current character.
+  int value = 0; // Number read.
+
+  do {
+
+    c = fgetc(file);
+    if (c == '#') while (c != '\n' && c != EOF) c = fgetc(file);
+  } while (c != EOF && !isdigit(c));
+  if (c == EOF) return -1;
+
+  while (c != EOF && isdigit(c)) {
+
+    value = value * 10 + (c - '0');
+    c = fgetc(file);
+  }
+  return value;
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Read a PBM image (P1 plain or P4 raw). PBM pixels are 1 for black, the image pixels are 1 for white like the Arduboy screen. Returns false on failure.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+static bool readPbm(const char *path, Image &image) {
+
+  FILE *file;           // PBM file.
+  char magic[2];        // PBM magic number : P1 or P4.
+  int value = 0;        // Pixel (P1) or pixels byte (P4) read from the file.
+  bool ok = true;       // Tells if the image was read.
+
+  file = fopen(path, "rb");
+  if (!file) {
+
+    fprintf(stderr, "%s : can't open the file\n", path);
+    return false;
+  }
+
+  if (fread(magic, 1, 2, file) != 2 || magic[0] != 'P' || (magic[1] != '1' && magic[1] != '4')) {
+
+    fprintf(stderr, "%s : not a PBM image (P1 or P4)\n", path);
+    fclose(file);
+    return false;
+  }
+  image.width = readPbmNumber(file);
+  image.height = readPbmNumber(file);
+  if (image.width <= 0 || image.height <= 0) {
+
+    fprintf(stderr, "%s : bad image size\n", path);
+    fclose(file);
+    return false;
+  }
+  image.pixels.assign(image.width * image.height, 0);
+
+  // The single white space after the P4 header was read by readPbmNumber()
+  for (int y=0; y<image.height && ok; y++) {
+
+    for (int x=0; x<image.width && ok; x++) {
+
+      if (magic[1] == '1') {
+
+        do value = fgetc(file); while (value != EOF && value != '0' && value != '1');
+        ok = value != EOF;
+        image.pixels[y * image.width + x] = value == '0';
+      }
+      else {
+
+        if ((x & 7) == 0) value = fgetc(file);
+        ok = value != EOF;
+        image.pixels[y * image.width + x] = ((value >> (7 - (x & 7))) & 1) == 0;
+      }
+    }
+  }
+  fclose(file);
+
+  if (!ok) fprintf(stderr, "%s : truncated image\n", path);
+  return ok;
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Get the power of 2 of a texture size, or -1 if the size is not a power of 2 supported by the engine.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+static int getSizeShift(int size) {
+
+  for (int shift=TEXTURE_MIN_SIZE_SHIFT; shift<=TEXTURE_MAX_SIZE_SHIFT; shift++) {
+
+    if (size == (1 << shift)) return shift;
+  }
+  return -1;
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Build a level of detail of a texture, 1 << shift times smaller. Each texel is the majority of the texture texels it covers (of the opaque ones for a
+// masked texture) and each mask texel is opaque if most of the mask texels it covers are opaque. The levels are built from the full size texture, so
+// the errors of a level are not carried to the next ones.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+static void reduceImage(const Image &image, const Image *mask, int shift, Image &level, Image *levelMask) {
+
+  int white = 0;  // Number of white opaque texels covered by the level texel.
+  int opaque = 0; // Number of opaque texels covered by the level texel.
+  int pixel = 0;  // Position of the current texel in the texture.
+
+  level.width = image.width >> shift;
+  level.height = image.height >> shift;
+  level.pixels.assign(level.width * level.height, 0);
+  if (levelMask) *levelMask = level;
+
+  for (int y=0; y<level.height; y++) {
+
+    for (int x=0; x<level.width; x++) {
+
+      white = 0;
+      opaque = 0;
+      for (int j=0; j<(1 << shift); j++) {
+
+        for (int i=0; i<(1 << shift); i++) {
+
+          pixel = ((y << shift) + j) * image.width + (x << shift) + i;
+          if (mask && !mask->pixels[pixel]) continue;
+          opaque++;
+          white += image.pixels[pixel];
+        }
+      }
+      level.pixels[y * level.width + x] = white * 2 > opaque;
+      if (levelMask) levelMask->pixels[y * level.width + x] = opaque * 2 > (1 << (shift << 1));
+    }
+  }
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Get the average texel of a texture : 1 if most of the texels (of the opaque ones for a masked texture) are white.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+static uint8_t getAverageTexel(const Image &image, const Image *mask) {
+
+  int white = 0;  // Number of white opaque texels.
+  int opaque = 0; // Number of opaque texels.
+
+  for (size_t pixel=0; pixel<image.pixels.size(); pixel++) {
+
+    if (mask && !mask->pixels[pixel]) continue;
+    opaque++;
+    white += image.pixels[pixel];
+  }
+  return white * 2 > opaque;
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pack the texels of a texture level, 8 texels per byte (most significant bit first), row by row or column by column.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+static void packLevel(const Image &image, uint8_t format, std::vector<uint8_t> &bytes) {
+
+  int texelCount = image.width * image.height; // Number of texels of the level.
+  int texelPos = 0;                            // Position of the texel in the packed level.
+  size_t levelStart = bytes.size();            // Position of the level in the texture bytes.
+
+  bytes.resize(levelStart + ((texelCount + 7) >> 3), 0);
+  for (int y=0; y<image.height; y++) {
+
+    for (int x=0; x<image.width; x++) {
+
+      if (format == TEXTURE_FORMAT_ROW_MAJOR) texelPos = y * image.width + x;
+      else texelPos = x * image.height + y;
+      if (image.pixels[y * image.width + x]) bytes[levelStart + (texelPos >> 3)] |= 128 >> (texelPos & 7);
+    }
+  }
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Encode a texture level as runs : width + 1 column offsets (16 bits, low byte first, from the start of the level, the last one is the size of the
+// level) followed by the runs of each column, from top to bottom.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+static void encodeRleLevel(const Image &image, std::vector<uint8_t> &bytes) {
+
+  size_t levelStart = bytes.size(); // Position of the level in the texture bytes.
+  size_t offset = 0;                // Offset of the current column from the start of the level.
+  uint8_t value = 0;                // Value of the texels of the current run.
+  int length = 0;                   // Number of texels of the current run.
+
+  bytes.resize(levelStart + ((image.width + 1) << 1), 0);
+  for (int x=0; x<=image.width; x++) {
+
+    offset = bytes.size() - levelStart;
+    bytes[levelStart + (x << 1)] = offset & 0xFF;
+    bytes[levelStart + (x << 1) + 1] = offset >> 8;
+    if (x == image.width) break;
+
+    for (int y=0; y<image.height; y+=length) {
+
+      value = image.pixels[y * image.width + x];
+      length = 1;
+      while (y + length < image.height && length < TEXTURE_RLE_LENGTH_MASK && image.pixels[(y + length) * image.width + x] == value) length++;
+      bytes.push_back((value ? TEXTURE_RLE_VALUE : 0) | length);
+    }
+  }
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Convert a texture into its runtime format : descriptor, levels of detail (the last one is the average texel byte) and mask. Returns false if the
+// texture can't be converted.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+static bool convertTexture(Texture &texture) {
+
+  int widthShift = 0;                  // Texture width (power of 2).
+  int heightShift = 0;                 // Texture height (power of 2).
+  int lodCount = 0;                    // Number of levels of detail.
+  std::vector<Image> levels;           // Texture levels, from the full size texture to the smallest level of detail.
+  std::vector<Image> maskLevels;       // Mask levels (masked textures only).
+  std::vector<uint8_t> columnBytes;    // Texels packed column by column (FORMAT_AUTO).
+  std::vector<uint8_t> rleBytes;       // Texels encoded as runs (FORMAT_AUTO).
+  uint8_t average = 0;                 // Average texel.
+
+  widthShift = getSizeShift(texture.image.width);
+  heightShift = getSizeShift(texture.image.height);
+  if (widthShift < 0 || heightShift < 0) {
+
+    fprintf(stderr, "%s : texture width and height must be 8, 16, 32 or 64 texels\n", texture.path.c_str());
+    return false;
+  }
+  if (texture.masked && (texture.mask.width != texture.image.width || texture.mask.height != texture.image.height)) {
+
+    fprintf(stderr, "%s : the mask and the texture must have the same size\n", texture.path.c_str());
+    return false;
+  }
+  if (texture.masked && texture.format == TEXTURE_FORMAT_RLE) {
+
+    fprintf(stderr, "%s : RLE textures can't be masked\n", texture.path.c_str());
+    return false;
+  }
+
+  // A level of detail is used when the projected slice is lower than the level above, so the automatic count stops at 4 texels high
+  if (texture.lodCount == LOD_AUTO) lodCount = heightShift - LOD_AUTO_MIN_SIZE_SHIFT + 1;
+  else lodCount = texture.lodCount;
+  if (lodCount > widthShift) lodCount = widthShift;
+  if (lodCount > heightShift) lodCount = heightShift;
+
+  // Build the levels of detail. The last level of detail is only the average texel.
+  levels.push_back(texture.image);
+  if (texture.masked) maskLevels.push_back(texture.mask);
+  for (int level=1; level<lodCount; level++) {
+
+    levels.push_back(Image());
+    if (texture.masked) maskLevels.push_back(Image());
+    reduceImage(texture.image, texture.masked ? &texture.mask : 0, level, levels[level], texture.masked ? &maskLevels[level] : 0);
+  }
+
+  // Choose the packing format
+  if (texture.format == FORMAT_AUTO) {
+
+    if (texture.masked) texture.format = TEXTURE_FORMAT_COLUMN_MAJOR;
+    else {
+
+      for (size_t level=0; level<levels.size(); level++) {
+
+        packLevel(levels[level], TEXTURE_FORMAT_COLUMN_MAJOR, columnBytes);
+        encodeRleLevel(levels[level], rleBytes);
+      }
+      texture.format = rleBytes.size() <= columnBytes.size() ? TEXTURE_FORMAT_RLE : TEXTURE_FORMAT_COLUMN_MAJOR;
+    }
+  }
+
+  // Descriptor
+  texture.bytes.clear();
+  texture.bytes.push_back(widthShift);
+  texture.bytes.push_back(heightShift);
+  texture.bytes.push_back(texture.format);
+  texture.bytes.push_back(lodCount | (texture.masked ? TEXTURE_MASKED : 0));
+
+  // Texels, then mask
+  for (size_t level=0; level<levels.size(); level++) {
+
+    if (texture.format == TEXTURE_FORMAT_RLE) encodeRleLevel(levels[level], texture.bytes);
+    else packLevel(levels[level], texture.format, texture.bytes);
+  }
+  if (lodCount) {
+
+    average = getAverageTexel(texture.image, texture.masked ? &texture.mask : 0);
+    texture.bytes.push_back(average ? 0xFF : 0x00);
+  }
+  if (texture.masked) {
+
+    for (size_t level=0; level<maskLevels.size(); level++) packLevel(maskLevels[level], texture.format, texture.bytes);
+    if (lodCount) texture.bytes.push_back(getAverageTexel(texture.mask, 0) ? 0xFF : 0x00);
+  }
+
+  return true;
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Read a world map : one row of blocks by line, the blocks separated with commas or spaces. Returns false on failure.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+static bool readMap(const char *path, WorldMap &worldMap) {
+
+  FILE *file;             // World map file.
+  char line[4096];        // Current line of the file.
+  char *token;            // Current block of the line.
+  char *end;              // End of the number read in the block.
+  long value = 0;         // Block type or spawn point rotation.
+  int rowWidth = 0;       // Number of blocks of the current row.
+  int lineNumber = 0;     // Number of the current line.
+
+  file = fopen(path, "r");
+  if (!file) {
+
+    fprintf(stderr, "%s : can't open the file\n", path);
+    return false;
+  }
+
+  while (fgets(line, sizeof(line), file)) {
+
+    lineNumber++;
+    rowWidth = 0;
+    for (token=strtok(line, ", \t\r\n"); token; token=strtok(0, ", \t\r\n")) {
+
+      // Spawn point : an empty block with the player in its middle
+      if (toupper(token[0]) == 'S') {
+
+        value = token[1] ? strtol(token + 1, &end, 10) : 0;
+        if (token[1] && *end) {
+
+          fprintf(stderr, "%s:%d : bad spawn point \"%s\"\n", path, lineNumber, token);
+          fclose(file);
+          return false;
+        }
+        worldMap.spawns.push_back(rowWidth * BLOCK_SIZE + (BLOCK_SIZE >> 1));
+        worldMap.spawns.push_back(worldMap.height * BLOCK_SIZE + (BLOCK_SIZE >> 1));
+        worldMap.spawns.push_back(((value % 360) + 360) % 360);
+        value = 0;
+      }
+      
+      // Light source : an empty block with the light in its middle
+      else if (toupper(token[0]) == 'L') {
+
+        value = token[1] ? strtol(token + 1, &end, 10) : LIGHT_DEFAULT_RADIUS;
+        if ((token[1] && *end) || value < 1 || value > 255) {
+
+          fprintf(stderr, "%s:%d : bad light source \"%s\"\n", path, lineNumber, token);
+          fclose(file);
+          return false;
+        }
+        worldMap.lights.push_back(rowWidth * BLOCK_SIZE + (BLOCK_SIZE >> 1));
+        worldMap.lights.push_back(worldMap.height * BLOCK_SIZE + (BLOCK_SIZE >> 1));
+        worldMap.lights.push_back(value * BLOCK_SIZE);
+        value = 0;
+      }
+      else {
+
+        value = strtol(token, &end, 10);
+        if (*end || value < 0 || value > 255) {
+
+          fprintf(stderr, "%s:%d : bad block \"%s\"\n", path, lineNumber, token);
+          fclose(file);
+          return false;
+        }
+      }
+      worldMap.blocks.push_back(value);
+      rowWidth++;
+    }
+
+    // Empty lines are ignored
+    if (!rowWidth) continue;
+    if (worldMap.height && rowWidth != worldMap.width) {
+
+      fprintf(stderr, "%s:%d : all the rows must have the same width\n", path, lineNumber);
+      fclose(file);
+      return false;
+    }
+    worldMap.width = rowWidth;
+    worldMap.height++;
+  }
+  fclose(file);
+
+  if (!worldMap.width || worldMap.width > 255 || worldMap.height > 255) {
+
+    fprintf(stderr, "%s : world map width and height must be 1 to 255 blocks\n", path);
+    return false;
+  }
+  return true;
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Check a world map against the textures : each block type needs a texture. A map whose border is not made of blocks is allowed but reported, because
+// the rays and the player then reach the world border.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+static bool checkMap(const WorldMap &worldMap, size_t textureCount) {
+
+  bool enclosed = true; // Tells if the border of the world map is made of blocks.
+  uint8_t block = 0;    // Current block.
+
+  for (int y=0; y<worldMap.height; y++) {
+
+    for (int x=0; x<worldMap.width; x++) {
+
+      block = worldMap.blocks[y * worldMap.width + x];
+      if (block > textureCount) {
+
+        fprintf(stderr, "%s : block %d (%d, %d) has no texture\n", worldMap.path.c_str(), block, x, y);
+        return false;
+      }
+      if (!block && (x == 0 || y == 0 || x == worldMap.width - 1 || y == worldMap.height - 1)) enclosed = false;
+    }
+  }
+  if (!enclosed) fprintf(stderr, "%s : warning : the world map is not enclosed by blocks (see --border)\n", worldMap.path.c_str());
+  if (worldMap.spawns.empty()) fprintf(stderr, "%s : warning : the world map has no spawn point\n", worldMap.path.c_str());
+
+  return true;
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Surround the world map with blocks of a given type. The spawn points and the light sources move with the blocks.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+static bool addBorder(WorldMap &worldMap, uint8_t block) {
+
+  std::vector<uint8_t> blocks;      // Blocks of the bordered world map, row by row.
+  int width = worldMap.width + 2;   // Width of the bordered world map (blocks).
+  int height = worldMap.height + 2; // Height of the bordered world map (blocks).
+
+  if (width > 255 || height > 255) {
+
+    fprintf(stderr, "%s : the world map is too big for a border\n", worldMap.path.c_str());
+    return false;
+  }
+
+  blocks.assign(width * height, block);
+  for (int y=0; y<worldMap.height; y++) {
+
+    memcpy(blocks.data() + (y + 1) * width + 1, worldMap.blocks.data() + y * worldMap.width, worldMap.width);
+  }
+  worldMap.blocks.swap(blocks);
+  worldMap.width = width;
+  worldMap.height = height;
+
+  for (size_t spawn=0; spawn<worldMap.spawns.size(); spawn+=3) {
+
+    worldMap.spawns[spawn] += BLOCK_SIZE;
+    worldMap.spawns[spawn + 1] += BLOCK_SIZE;
+  }
+  for (size_t source=0; source<worldMap.lights.size(); source+=3) {
+
+    worldMap.lights[source] += BLOCK_SIZE;
+    worldMap.lights[source + 1] += BLOCK_SIZE;
+  }
+  return true;
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Tells if a block of the world map is solid. The blocks outside of the world map are solid.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+static bool isSolidBlock(const WorldMap &worldMap, int blockX, int blockY) {
+
+  if (blockX < 0 || blockY < 0 || blockX >= worldMap.width || blockY >= worldMap.height) return true;
+  return worldMap.blocks[blockY * worldMap.width + blockX] > 0;
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Bake the light map : the light level of each block face seen from an empty block. The light of a sample point is the ambient light plus, for each
+// light source which sees it, a light decreasing with the distance and with the angle between the face and the light source. A light source sees a
+// sample point when an engine query between them hits no block.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+static void bakeLightMap(WorldMap &worldMap, float ambient) {
+
+  static const int faceNormals[4][2] = { { 0, -1 }, { 1, 0 }, { 0, 1 }, { -1, 0 } }; // Normal of each face : north, east, south and west.
+  static ARCE arce;       // Engine answering the occlusion queries (static : it is large).
+  ARCERayQuery query;     // Query between a light source and a sample point.
+  int sampleX = 0;        // X position of the current sample point, just in front of the face (world coordinates).
+  int sampleY = 0;        // Y position of the current sample point, just in front of the face (world coordinates).
+  float toLightX = 0;     // X distance between the sample point and the light source (world coordinates).
+  float toLightY = 0;     // Y distance between the sample point and the light source (world coordinates).
+  float distance = 0;     // Distance between the sample point and the light source (world coordinates).
+  float facing = 0;       // Cosinus of the angle between the face normal and the light source.
+  float light = 0;        // Light received by the face (0 to 1).
+  int level = 0;          // Light level of the face (0 = lit).
+
+  arce.loadWorldMap(worldMap.blocks.data(), worldMap.width, worldMap.height);
+  worldMap.lightMap.assign(worldMap.width * worldMap.height, 0);
+  for (int blockY=0; blockY<worldMap.height; blockY++) {
+
+    for (int blockX=0; blockX<worldMap.width; blockX++) {
+
+      if (!isSolidBlock(worldMap, blockX, blockY)) continue;
+
+      for (int face=LIGHT_FACE_NORTH; face<=LIGHT_FACE_WEST; face++) {
+
+        // Hidden faces are never seen by the rays
+        if (isSolidBlock(worldMap, blockX + faceNormals[face][0], blockY + faceNormals[face][1])) continue;
+
+        light = 0;
+        for (int sample=0; sample<LIGHT_SAMPLES; sample++) {
+
+          // Sample points are spread along the face, one world unit in front of it (inside the empty block)
+          sampleX = blockX * BLOCK_SIZE + (faceNormals[face][0] ? (faceNormals[face][0] > 0 ? BLOCK_SIZE : -1) : (sample * 2 + 1) * BLOCK_SIZE / (LIGHT_SAMPLES * 2));
+          sampleY = blockY * BLOCK_SIZE + (faceNormals[face][1] ? (faceNormals[face][1] > 0 ? BLOCK_SIZE : -1) : (sample * 2 + 1) * BLOCK_SIZE / (LIGHT_SAMPLES * 2));
+
+          for (size_t source=0; source<worldMap.lights.size(); source+=3) {
+
+            toLightX = worldMap.lights[source] - sampleX;
+            toLightY = worldMap.lights[source + 1] - sampleY;
+            distance = sqrtf(toLightX * toLightX + toLightY * toLightY);
+            if (distance >= worldMap.lights[source + 2]) continue;
+            facing = distance > 0 ? (toLightX * faceNormals[face][0] + toLightY * faceNormals[face][1]) / distance : 1;
+            if (facing <= 0) continue;
+            query.originX = worldMap.lights[source];
+            query.originY = worldMap.lights[source + 1];
+            query.targetX = sampleX;
+            query.targetY = sampleY;
+            if (arce.castQuery(&query)) continue;
+            light += (1 - distance / worldMap.lights[source + 2]) * (0.5f + 0.5f * facing) / LIGHT_SAMPLES;
+          }
+        }
+
+        // Quantize the light : level 0 for a fully lit face, LIGHT_LEVEL_COUNT - 1 for a face without light
+        light += ambient;
+        level = (LIGHT_LEVEL_COUNT - 1) - (int)(light * LIGHT_LEVEL_COUNT);
+        if (level < 0) level = 0;
+        if (level > LIGHT_LEVEL_COUNT - 1) level = LIGHT_LEVEL_COUNT - 1;
+        worldMap.lightMap[blockY * worldMap.width + blockX] |= level << (face << 1);
+      }
+    }
+  }
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Write a 16 bits value in a level pack (low byte first).
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+static void setWord(std::vector<uint8_t> &bytes, size_t position, uint16_t value) {
+
+  bytes[position] = value & 0xFF;
+  bytes[position + 1] = value >> 8;
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Build a level pack (see the level pack section in ARCE.h). Returns false if the level pack is bigger than 64 KB.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+static bool buildLevelPack(const WorldMap &worldMap, const std::vector<Texture> &textures, std::vector<uint8_t> &pack) {
+
+  size_t texturesTable = 0; // Offset of the textures table.
+  bool heights = false;     // Tells if a block type is not BLOCK_SIZE high.
+
+  pack.assign(LEVEL_PACK_HEADER_SIZE, 0);
+  memcpy(pack.data(), "ARCL", 4);
+  pack[4] = LEVEL_PACK_VERSION;
+  pack[5] = LEVEL_MAP_RAW;
+  pack[6] = worldMap.width;
+  pack[7] = worldMap.height;
+  pack[10] = textures.size();
+  pack[11] = worldMap.spawns.size() / 3;
+
+  // World map
+  setWord(pack, 8, pack.size());
+  pack.insert(pack.end(), worldMap.blocks.begin(), worldMap.blocks.end());
+
+  // Textures table and textures
+  texturesTable = pack.size();
+  setWord(pack, 12, texturesTable);
+  pack.resize(pack.size() + (textures.size() << 1), 0);
+  for (size_t texture=0; texture<textures.size(); texture++) {
+
+    if (pack.size() > 0xFFFF) break;
+    setWord(pack, texturesTable + (texture << 1), pack.size());
+    pack.insert(pack.end(), textures[texture].bytes.begin(), textures[texture].bytes.end());
+    if (textures[texture].height != BLOCK_SIZE) heights = true;
+  }
+
+  // Spawn points
+  if (pack.size() > 0xFFFF) return false;
+  setWord(pack, 14, pack.size());
+  for (size_t value=0; value<worldMap.spawns.size(); value++) {
+
+    pack.push_back(worldMap.spawns[value] & 0xFF);
+    pack.push_back((uint16_t)worldMap.spawns[value] >> 8);
+  }
+
+  // Block heights (only when a block type is not BLOCK_SIZE high)
+  if (heights) {
+
+    if (pack.size() > 0xFFFF) return false;
+    setWord(pack, 16, pack.size());
+    for (size_t texture=0; texture<textures.size(); texture++) pack.push_back(textures[texture].height);
+  }
+
+  // Light map (only when the world map has light sources)
+  if (!worldMap.lightMap.empty()) {
+
+    if (pack.size() > 0xFFFF) return false;
+    setWord(pack, 20, pack.size());
+    pack.insert(pack.end(), worldMap.lightMap.begin(), worldMap.lightMap.end());
+  }
+
+  if (pack.size() > 0xFFFF) return false;
+  setWord(pack, 18, pack.size());
+  return true;
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Write bytes as the body of a C++ array, 16 bytes per line. A comma follows the last byte when more bytes are written after them.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+static void writeBytes(FILE *file, const uint8_t *bytes, size_t size, bool more = false) {
+
+  for (size_t byte=0; byte<size; byte++) {
+
+    fprintf(file, "%s0x%02X%s", (byte & 15) ? "" : "  ", bytes[byte], byte + 1 == size ? (more ? ",\n" : "\n") : ((byte & 15) == 15 ? ",\n" : ","));
+  }
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Write the textures, the world map, the block heights and the spawn points as PROGMEM arrays. Returns false on failure.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+static bool writeHeader(const char *path, const WorldMap *worldMap, const std::vector<Texture> &textures) {
+
+  static const char *formatNames[] = { "TEXTURE_FORMAT_ROW_MAJOR", "TEXTURE_FORMAT_COLUMN_MAJOR", "TEXTURE_FORMAT_RLE" }; // Packing format constants.
+  static const char *sizeNames[] = { "", "", "", "TEXTURE_SIZE_8", "TEXTURE_SIZE_16", "TEXTURE_SIZE_32", "TEXTURE_SIZE_64" }; // Texture size constants.
+  FILE *file;        // Header file.
+  bool heights = false; // Tells if a block type is not BLOCK_SIZE high.
+
+  file = fopen(path, "w");
+  if (!file) {
+
+    fprintf(stderr, "%s : can't create the file\n", path);
+    return false;
+  }
+
+  fprintf(file, "// Generated by ARCEAssets. Do not edit : edit the images and the world map, then run ARCEAssets again.\n\n#include \"ARCE.h\"\n");
+
+  for (size_t texture=0; texture<textures.size(); texture++) {
+
+    const Texture &current = textures[texture];
+    fprintf(file, "\n// %s : block \"%d\" in the world map\nPROGMEM const uint8_t %s[] = {\n  \n", current.path.c_str(), (int)texture + 1, current.name.c_str());
+    fprintf(file, "  %s, %s, %s, %d%s,\n  \n", sizeNames[current.bytes[0]], sizeNames[current.bytes[1]], formatNames[current.bytes[2]], current.bytes[3] & 15,
+            current.masked ? " | TEXTURE_MASKED" : "");
+    writeBytes(file, current.bytes.data() + 4, current.bytes.size() - 4);
+    fprintf(file, "};\n");
+    if (current.height != BLOCK_SIZE) heights = true;
+  }
+
+  if (heights) {
+
+    fprintf(file, "\n// Block heights, to be loaded with ARCE::loadBlockHeights()\nPROGMEM const uint8_t blockHeights[%d] = {\n  \n  ", (int)textures.size());
+    for (size_t texture=0; texture<textures.size(); texture++) fprintf(file, "%d%s", textures[texture].height, texture + 1 < textures.size() ? ", " : "\n");
+    fprintf(file, "};\n");
+  }
+
+  if (worldMap) {
+
+    fprintf(file, "\n// %s : %d x %d world map\nPROGMEM const uint8_t %s[%d] = {\n  \n", worldMap->path.c_str(), worldMap->width, worldMap->height, worldMap->name.c_str(),
+            worldMap->width * worldMap->height);
+    for (int y=0; y<worldMap->height; y++) {
+
+      fprintf(file, "  ");
+      for (int x=0; x<worldMap->width; x++) fprintf(file, "%d%s", worldMap->blocks[y * worldMap->width + x], (x + 1 < worldMap->width || y + 1 < worldMap->height) ? "," : "");
+      fprintf(file, "\n");
+    }
+    fprintf(file, "};\n");
+
+    if (!worldMap->spawns.empty()) {
+
+      fprintf(file, "\n// Spawn points : X, Y (world coordinates) and rotation (degrees) of the player\nPROGMEM const int16_t %sSpawns[%d] = {\n  \n",
+              worldMap->name.c_str(), (int)worldMap->spawns.size());
+      for (size_t value=0; value<worldMap->spawns.size(); value+=3) {
+
+        fprintf(file, "  %d, %d, %d%s\n", worldMap->spawns[value], worldMap->spawns[value + 1], worldMap->spawns[value + 2], value + 3 < worldMap->spawns.size() ? "," : "");
+      }
+      fprintf(file, "};\n");
+    }
+
+    if (!worldMap->lightMap.empty()) {
+
+      fprintf(file, "\n// Light map, to be loaded with ARCE::loadLightMap()\nPROGMEM const uint8_t %sLight[%d] = {\n  \n", worldMap->name.c_str(),
+              worldMap->width * worldMap->height);
+      for (int y=0; y<worldMap->height; y++) writeBytes(file, worldMap->lightMap.data() + y * worldMap->width, worldMap->width, y + 1 < worldMap->height);
+      fprintf(file, "};\n");
+    }
+  }
+
+  fclose(file);
+  return true;
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Write a level pack file, or a header with the level pack as a PROGMEM array when arrayName is given. Returns false on failure.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+static bool writeLevelPack(const char *path, const char *arrayName, const std::vector<uint8_t> &pack) {
+
+  FILE *file; // Level pack file or header file.
+  bool ok;    // Tells if the file was written.
+
+  file = fopen(path, arrayName ? "w" : "wb");
+  if (!file) {
+
+    fprintf(stderr, "%s : can't create the file\n", path);
+    return false;
+  }
+
+  if (arrayName) {
+
+    fprintf(file, "// Generated by ARCEAssets. Do not edit : edit the images and the world map, then run ARCEAssets again.\n\n#include \"ARCE.h\"\n\n");
+    fprintf(file, "// Level pack, to be loaded with ARCE::loadLevelPack()\nPROGMEM const uint8_t %s[%d] = {\n  \n", arrayName, (int)pack.size());
+    writeBytes(file, pack.data(), pack.size());
+    fprintf(file, "};\n");
+    ok = !ferror(file);
+  }
+  else ok = fwrite(pack.data(), 1, pack.size(), file) == pack.size();
+
+  if (fclose(file) != 0) ok = false;
+  if (!ok) fprintf(stderr, "%s : can't write the file\n", path);
+  return ok;
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Split a NAME=FILE argument. Returns false if there is no name.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+static bool splitNamedPath(const char *argument, std::string &name, std::string &path) {
+
+  const char *separator = strchr(argument, '='); // Separator between the name and the path.
+
+  if (!separator || separator == argument || !separator[1]) {
+
+    fprintf(stderr, "%s : NAME=FILE expected\n", argument);
+    return false;
+  }
+  name.assign(argument, separator - argument);
+  path.assign(separator + 1);
+  return true;
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Print the command-line usage.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+static void printUsage() {
+
+  fprintf(stderr, "Usage : ARCEAssets [options] --texture NAME=FILE.pbm ... --map NAME=FILE.csv [--header FILE.h] [--pack FILE.bin] [--pack-array NAME=FILE.h]\n");
+  fprintf(stderr, "Texture options (apply to the next textures) : --format row|column|rle|auto, --lod COUNT|auto\n");
+  fprintf(stderr, "Texture options (apply to the next texture only) : --mask FILE.pbm, --height HEIGHT\n");
+  fprintf(stderr, "World map options : --ambient PERCENT, --border BLOCK\n");
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// ARCEAssets entry point
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+int main(int argc, char **argv) {
+
+  std::vector<Texture> textures;       // Textures to convert.
+  WorldMap worldMap;                   // World map to convert.
+  bool hasMap = false;                 // Tells if a world map was given.
+  Texture next;                        // Options of the next texture.
+  std::string headerPath;              // Path of the header output.
+  std::string packPath;                // Path of the level pack output.
+  std::string packArrayName;           // Name of the level pack array output.
+  std::string packArrayPath;           // Path of the level pack array output.
+  std::vector<uint8_t> pack;           // Level pack.
+  float ambient = 0;                   // Light received by all the block faces (0 to 1).
+  int border = 0;                      // Block type of the border added around the world map (0 = no border).
+  const char *option;                  // Current option.
+  const char *value;                   // Value of the current option.
+
+  // Read the command line
+  for (int argument=1; argument<argc; argument++) {
+
+    option = argv[argument];
+    if (argument + 1 >= argc) {
+
+      printUsage();
+      return 1;
+    }
+    value = argv[++argument];
+
+    if (!strcmp(option, "--format")) {
+
+      if (!strcmp(value, "row")) next.format = TEXTURE_FORMAT_ROW_MAJOR;
+      else if (!strcmp(value, "column")) next.format = TEXTURE_FORMAT_COLUMN_MAJOR;
+      else if (!strcmp(value, "rle")) next.format = TEXTURE_FORMAT_RLE;
+      else if (!strcmp(value, "auto")) next.format = FORMAT_AUTO;
+      else {
+
+        fprintf(stderr, "%s : unknown texture format\n", value);
+        return 1;
+      }
+    }
+    else if (!strcmp(option, "--lod")) {
+
+      if (!strcmp(value, "auto")) next.lodCount = LOD_AUTO;
+      else if (atoi(value) >= 0 && atoi(value) <= TEXTURE_MAX_LOD_COUNT) next.lodCount = atoi(value);
+      else {
+
+        fprintf(stderr, "%s : levels of detail count must be 0 to %d\n", value, TEXTURE_MAX_LOD_COUNT);
+        return 1;
+      }
+    }
+    else if (!strcmp(option, "--mask")) {
+
+      if (!readPbm(value, next.mask)) return 1;
+      next.masked = true;
+    }
+    else if (!strcmp(option, "--height")) {
+
+      if (atoi(value) < 1 || atoi(value) > 255) {
+
+        fprintf(stderr, "%s : block height must be 1 to 255\n", value);
+        return 1;
+      }
+      next.height = atoi(value);
+    }
+    else if (!strcmp(option, "--texture")) {
+
+      if (!splitNamedPath(value, next.name, next.path) || !readPbm(next.path.c_str(), next.image) || !convertTexture(next)) return 1;
+      textures.push_back(next);
+
+      // The mask and the height only apply to one texture
+      next.masked = false;
+      next.mask = Image();
+      next.height = BLOCK_SIZE;
+    }
+    else if (!strcmp(option, "--map")) {
+
+      if (hasMap) {
+
+        fprintf(stderr, "Only one world map can be converted at a time\n");
+        return 1;
+      }
+      if (!splitNamedPath(value, worldMap.name, worldMap.path) || !readMap(worldMap.path.c_str(), worldMap)) return 1;
+      hasMap = true;
+    }
+    else if (!strcmp(option, "--ambient")) {
+
+      if (atoi(value) < 0 || atoi(value) > 100) {
+
+        fprintf(stderr, "%s : ambient light must be 0 to 100\n", value);
+        return 1;
+      }
+      ambient = atoi(value) / 100.0f;
+    }
+    else if (!strcmp(option, "--border")) {
+
+      if (atoi(value) < 1 || atoi(value) > 255) {
+
+        fprintf(stderr, "%s : border block must be 1 to 255\n", value);
+        return 1;
+      }
+      border = atoi(value);
+    }
+    else if (!strcmp(option, "--header")) headerPath = value;
+    else if (!strcmp(option, "--pack")) packPath = value;
+    else if (!strcmp(option, "--pack-array")) {
+
+      if (!splitNamedPath(value, packArrayName, packArrayPath)) return 1;
+    }
+    else {
+
+      printUsage();
+      return 1;
+    }
+  }
+
+  if (textures.size() > 255 || (headerPath.empty() && packPath.empty() && packArrayPath.empty())) {
+
+    printUsage();
+    return 1;
+  }
+  if (hasMap && border && !addBorder(worldMap, border)) return 1;
+  if (hasMap && !checkMap(worldMap, textures.size())) return 1;
+  if (hasMap && !worldMap.lights.empty()) bakeLightMap(worldMap, ambient);
+
+  // Write the outputs
+  if (!headerPath.empty() && !writeHeader(headerPath.c_str(), hasMap ? &worldMap : 0, textures)) return 1;
+  if (!packPath.empty() || !packArrayPath.empty()) {
+
+    if (!hasMap) {
+
+      fprintf(stderr, "A level pack needs a world map\n");
+      return 1;
+    }
+    if (!buildLevelPack(worldMap, textures, pack)) {
+
+      fprintf(stderr, "The level pack is bigger than 64 KB\n");
+      return 1;
+    }
+    if (!packPath.empty() && !writeLevelPack(packPath.c_str(), 0, pack)) return 1;
+    if (!packArrayPath.empty() && !writeLevelPack(packArrayPath.c_str(), packArrayName.c_str(), pack)) return 1;
+  }
+
+  for (size_t texture=0; texture<textures.size(); texture++) {
+
+    printf("%s : %d bytes\n", textures[texture].name.c_str(), (int)textures[texture].bytes.size());
+  }
+  if (!pack.empty()) printf("Level pack : %d bytes\n", (int)pack.size());
+
+  return 0;
+}
@@ -0,0 +1,261 @@
+//
+// ARCECheck : ARCE engine checks
+//
+// Copyright (C) 2015 Jerome Perrot (Initgraph)
+//
+// Notes :
+//
+//   ARCECheck is a command-line program which runs on a computer, not on the Arduboy. It builds the engine itself (ARCE.cpp) as a host build, and
+//   checks the engine behaviours which can't be seen on the screen of the device. Build it from this folder with any C++ compiler, for example :
+//
+//     g++ -O2 -DARCE_HOST -DARCE_PROFILE -I../.. -o ARCECheck ARCECheck.cpp ../../ARCE.cpp
+//
+//   Then run it without any argument : each check prints its result, and the program returns 0 when all the checks passed. Run it with --capture in
+//   order to print the hashes of the demo replay sessions instead, as golden hashes arrays for ARCEDemoReplay.h.
+//
+//   Checks :
+//
+//     clear order : with the clearAfterDisplay option, displayFrame() clears each screen buffer byte right after sending it. Random frames of all
+//                   the views are rendered and displayed, with and without the dirty tracking : the display memory of the host build must hold the
+//                   rendered frame, and the screen buffer must be cleared. A byte cleared before being sent would reach the display memory as 0.
+//
+//     idle frames : without the clearAfterDisplay option, the screen buffer keeps the rendered view, and a frame where only a text changes (the
+//                   player did not move) marks only the page of that text. The display memory must hold the screen buffer after each frame, and
+//                   the idle frames must send far less than the whole screen buffer (ARCE_PROFILE counts the bytes sent to the display).
+//
+//     replay      : the replay sessions of the demo (ARCEDemo/ARCEDemoReplay.h) are played with the demo settings, and each rendered frame must match
+//                   its golden hash. The frame hashes are the CRC-CCITT of the screen buffer, as on the device.
+//
+//   A host build computes with a 32 bits int, the Arduboy with a 16 bits int. ARCEIntWidth.py rewrites ARCE.cpp with the AVR integer widths (see its
+//   notes) : ARCECheck built with the rewritten engine must pass the same checks, which tells that the golden hashes are the frames of the device.
+//
+// Licence :
+//
+//   This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by
+//   the Free Software Foundation; either version 2 of the License, or (at your option) any later version.
+//   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc.,
+//   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ARCE.h"
+#include "ARCEDemo/ARCEDemoAssets.h"
+#include "ARCEDemo/ARCEDemoReplay.h"
+
+#if !defined(ARCE_HOST) || !defined(ARCE_PROFILE)
+#error "ARCECheck must be built with -DARCE_HOST -DARCE_PROFILE"
+#endif
+
+#define CHECK_FRAMES 500               // Number of random frames rendered by a check.
+#define CHECK_IDLE_FRAMES 10           // Number of frames of each idle check frame sequence (the first one moves the player).
+#define CHECK_IDLE_MAX_BYTES 256       // Maximum number of bytes sent to the display by an idle frame, on average.
+#define CHECK_REPLAY_MAX_FRAMES 256    // Maximum number of frames of a demo replay session.
+
+// 8 x 8 world map with pillars, used by the checks
+PROGMEM const uint8_t checkMap[64] = {
+
+  1,1,1,1,1,1,1,1,
+  1,0,0,0,0,0,0,1,
+  1,0,1,0,0,1,0,1,
+  1,0,0,0,0,0,0,1,
+  1,0,0,0,0,0,0,1,
+  1,0,1,0,0,1,0,1,
+  1,0,0,0,0,0,0,1,
+  1,1,1,1,1,1,1,1
+};
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Move the player of an engine to a random place of the check map, with a random rotation, view and minimap
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+static void setRandomFrame(ARCE &arce) {
+
+  arce.player.x = BLOCK_SIZE + rand() % (6 * BLOCK_SIZE);
+  arce.player.y = BLOCK_SIZE + rand() % (6 * BLOCK_SIZE);
+  arce.player.rot = rand() % 360;
+  arce.view = rand() % 3;              // VIEW_2D_ONERAY, VIEW_2D or VIEW_3D_SOLID (the check map has no textures)
+  arce.minimap = rand() % 2;
+  arce.floorMode = (rand() % 2) ? SURFACE_CHECKERBOARD : SURFACE_NONE;
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Clear order check : each frame must reach the display memory intact while the screen buffer is cleared. Returns true if the check passed.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+static bool checkClearOrder() {
+
+  static ARCE arce;                    // Checked engine (static : its screen buffer and display memory are large).
+  uint8_t rendered[SCREEN_BUFFER_SIZE]; // Copy of the rendered frame.
+  int badFrames = 0;                   // Number of frames which did not reach the display memory intact.
+  int dirtyBytes = 0;                  // Number of screen buffer bytes left after displayFrame().
+
+  arce.start();
+  arce.loadWorldMap(checkMap, 8, 8);
+  arce.clearAfterDisplay = true;
+
+  for (int frame=0; frame<CHECK_FRAMES * 2; frame++) {
+
+    arce.dirtyTracking = frame >= CHECK_FRAMES;
+    setRandomFrame(arce);
+    arce.render();
+    memcpy(rendered, arce.screenBuffer, SCREEN_BUFFER_SIZE);
+    arce.displayFrame();
+
+    if (memcmp(rendered, arce.displayMemory, SCREEN_BUFFER_SIZE)) badFrames++;
+    for (int pos=0; pos<SCREEN_BUFFER_SIZE; pos++) if (arce.screenBuffer[pos]) dirtyBytes++;
+  }
+
+  printf("clear order : %d frames, %d not displayed intact, %d bytes not cleared\n", CHECK_FRAMES * 2, badFrames, dirtyBytes);
+  return !badFrames && !dirtyBytes;
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Idle frames check : the frames where only a text changes must reach the display memory while sending a few bytes. Returns true if the check passed.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+static bool checkIdleFrames() {
+
+  static ARCE arce;                    // Checked engine (static : its screen buffer and display memory are large).
+  int badFrames = 0;                   // Number of frames which did not reach the display memory intact.
+  int idleFrames = 0;                  // Number of idle frames.
+  uint32_t idleBytes = 0;              // Number of bytes sent to the display by the idle frames.
+
+  arce.start();
+  arce.loadWorldMap(checkMap, 8, 8);
+  arce.clearAfterDisplay = false;
+  arce.dirtyTracking = true;
+
+  for (int frame=0; frame<CHECK_FRAMES * 2; frame++) {
+
+    if (frame % CHECK_IDLE_FRAMES == 0) {
+
+      // The player moved : the kept frame is cleared and the view is rendered again
+      setRandomFrame(arce);
+      memset(arce.screenBuffer, 0, SCREEN_BUFFER_SIZE);
+      arce.markDirty(DIRTY_ALL_PAGES);
+      arce.render();
+    }
+    else {
+
+      // Only a text changed (like the FPS of the demo) : a few bytes of the first page are drawn
+      for (int pos=100; pos<112; pos++) arce.screenBuffer[pos] = rand();
+      arce.markDirty(0);
+    }
+
+    arce.displayFrame();
+
+    if (memcmp(arce.screenBuffer, arce.displayMemory, SCREEN_BUFFER_SIZE)) badFrames++;
+    if (frame % CHECK_IDLE_FRAMES) {
+
+      idleFrames++;
+      idleBytes += arce.frameStats.displayBytes;
+    }
+  }
+
+  printf("idle frames : %d frames, %d not displayed intact, %d idle frames sent %u bytes on average\n", CHECK_FRAMES * 2, badFrames, idleFrames,
+         (unsigned)(idleBytes / idleFrames));
+  return !badFrames && idleBytes / idleFrames <= CHECK_IDLE_MAX_BYTES;
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Play a replay session of the demo with the demo settings (see setup() and startReplaySession() in ARCEDemo.ino). The hash of each frame is saved in
+// a given array.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+static void playDemoSession(const DemoReplaySession *session, ARCEReplay &replay, uint16_t *frameHashes) {
+
+  static ARCE arce;                    // Engine playing the session (static : its screen buffer and display memory are large).
+
+  arce.start();
+  arce.clearAfterDisplay = true;
+  arce.dirtyTracking = true;
+  arce.texturesArray[0] = wall1;
+  arce.texturesArray[1] = wall2;
+  arce.texturesArray[2] = door;
+  arce.floorMode = SURFACE_CHECKERBOARD;
+  arce.minimap = true;
+  arce.minimapX = 68;
+  arce.resolution = RESOLUTION_HIGH;
+  arce.replay = &replay;
+
+  arce.loadWorldMap(session->worldMap, session->worldMapWidth, session->worldMapHeight);
+  arce.player.x = session->playerX;
+  arce.player.y = session->playerY;
+  arce.player.rot = session->playerRot;
+  arce.view = session->view;
+
+  replay.frameHashes = frameHashes;
+  replay.frameHashesSize = CHECK_REPLAY_MAX_FRAMES;
+  replay.play(session->session, session->sessionSize, session->goldenHashes);
+
+  // A played session runs one simulation tick for each frame, whatever the time
+  while (replay.mode != REPLAY_DONE) {
+
+    if (arce.step()) {
+
+      arce.render();
+      arce.displayFrame();
+    }
+  }
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Replay check : each frame of the demo replay sessions must match its golden hash. Returns true if the check passed.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+static bool checkReplay() {
+
+  ARCEReplay replay;                                 // Replay of the current session.
+  uint16_t frameHashes[CHECK_REPLAY_MAX_FRAMES];     // Hash of each frame of the current session.
+  bool passed = true;                                // Tells if all the sessions passed.
+
+  for (size_t session=0; session<sizeof(replaySessions) / sizeof(DemoReplaySession); session++) {
+
+    playDemoSession(&replaySessions[session], replay, frameHashes);
+    printf("replay : session %d, %d frames, %d not matching their golden hash\n", (int)session + 1, replay.frame, replay.failedFrames);
+    passed &= replay.passed();
+  }
+
+  return passed;
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// Play the demo replay sessions and print the hash of each frame, as the golden hashes arrays of ARCEDemoReplay.h
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+static void captureReplay() {
+
+  ARCEReplay replay;                                 // Replay of the current session.
+  uint16_t frameHashes[CHECK_REPLAY_MAX_FRAMES];     // Hash of each frame of the current session.
+
+  for (size_t session=0; session<sizeof(replaySessions) / sizeof(DemoReplaySession); session++) {
+
+    playDemoSession(&replaySessions[session], replay, frameHashes);
+    printf("// Golden hashes of session %d\nPROGMEM const uint16_t goldenHashes[] = {\n", (int)session + 1);
+    for (uint16_t frame=0; frame<replay.frame; frame++) {
+
+      printf("%s0x%04X%s", frame % 8 ? "" : "\n  ", frameHashes[frame], frame + 1 < replay.frame ? "," : "\n");
+    }
+    printf("};\n\n");
+  }
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+// ARCECheck entry point
+// ------------------------------------------------------------------------------------------------------------------------------------------------------
+int main(int argc, char **argv) {
+
+  bool passed = true;                  // Tells if all the checks passed.
+
+  if (argc > 1 && !strcmp(argv[1], "--capture")) {
+
+    captureReplay();
+    return 0;
+  }
+
+  srand(1);
+  passed &= checkClearOrder();
+  passed &= checkIdleFrames();
+  passed &= checkReplay();
+
+  return passed ? 0 : 1;
+}
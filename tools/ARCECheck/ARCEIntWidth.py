@@ -0,0 +1,262 @@
+#
+# ARCEIntWidth : AVR integer width rewrite of the ARCE engine, for ARCECheck
+#
+# Copyright (C) 2015 Jerome Perrot (Initgraph)
+#
+# Notes :
+#
+#   On the Arduboy, int is 16 bits wide and long is 32 bits wide, and the C++ integer promotions follow these widths. A host build of the engine
+#   computes with a 32 bits int instead, so an expression which overflows or changes its sign on the device may give another frame on a computer.
+#   ARCEIntWidth parses a source file of the engine with libclang for the AVR target, and writes it back with each integer operation cast to the
+#   host type of the AVR width : the operands and the result of the arithmetic operators, the left operand and the result of the shifts, the
+#   operands of the comparisons (in their AVR common type), the right operand of the compound assignments, the unary - and ~, and the ?: results.
+#   Built with -fwrapv, the rewritten engine computes as on the device. For example, from this folder :
+#
+#     python3 ARCEIntWidth.py ../../ARCE.cpp > ARCE16.cpp
+#     g++ -O2 -fwrapv -DARCE_HOST -DARCE_PROFILE -I../.. -o ARCECheck16 ARCECheck.cpp ARCE16.cpp
+#
+#   ARCECheck16 must pass the same checks as ARCECheck : the replay check then tells that the demo sessions give the golden hashes with the AVR
+#   integer widths too. The expressions which come from a macro body can't be rewritten, they are counted on the standard error output.
+#
+#   ARCEIntWidth needs the clang Python bindings (pip install libclang). The C library headers are replaced with small headers of the avr-libc
+#   widths, so no AVR toolchain is needed.
+#
+# Licence :
+#
+#   This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by
+#   the Free Software Foundation; either version 2 of the License, or (at your option) any later version.
+#   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+#   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+#
+#   You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc.,
+#   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+#
+
+import os, sys, tempfile
+import clang.cindex as ci
+
+# AVR integer types (canonical spelling) and the host types of the same width and signedness
+HOST_TYPES = {'int': 'int16_t', 'unsigned int': 'uint16_t', 'long': 'int32_t', 'unsigned long': 'uint32_t'}
+TYPE_RANKS = {'int': 1, 'unsigned int': 1, 'long': 2, 'unsigned long': 2, 'long long': 3, 'unsigned long long': 3}
+
+ARITHMETIC_OPERATORS = {'+', '-', '*', '/', '%', '&', '|', '^'}
+SHIFT_OPERATORS = {'<<', '>>'}
+COMPARISON_OPERATORS = {'<', '>', '<=', '>=', '==', '!='}
+OTHER_OPERATORS = {'=', '&&', '||', ','}
+
+# C library headers of the host build (ARCE_HOST), with the avr-libc widths. abs() is a macro of the Arduino core which keeps the type of its
+# argument : it is replaced with a template.
+AVR_HEADERS = {
+
+  'stdint.h': '''
+typedef signed char int8_t; typedef unsigned char uint8_t;
+typedef int int16_t; typedef unsigned int uint16_t;
+typedef long int32_t; typedef unsigned long uint32_t;
+typedef long long int64_t; typedef unsigned long long uint64_t;
+typedef int intptr_t; typedef unsigned int uintptr_t;
+#define INT16_MAX 0x7fff
+#define UINT16_MAX 0xffffU
+#define INT32_MAX 0x7fffffffL
+''',
+
+  'stdlib.h': '''
+typedef unsigned int size_t;
+template<class T> T arceAbs(T x);
+int rand(void);
+void *malloc(size_t); void free(void *);
+''',
+
+  'string.h': '''
+typedef unsigned int size_t;
+void *memset(void *, int, size_t); void *memcpy(void *, const void *, size_t); int memcmp(const void *, const void *, size_t);
+size_t strlen(const char *); char *strcpy(char *, const char *); int strcmp(const char *, const char *);
+''',
+
+  'time.h': '''
+struct timespec { long tv_sec; long tv_nsec; };
+#define CLOCK_MONOTONIC 1
+int clock_gettime(int, struct timespec *);
+''',
+
+  'fcntl.h': '''
+#define O_RDONLY 0
+int open(const char *, int, ...);
+''',
+
+  'unistd.h': '''
+int close(int);
+''',
+
+  'sys/mman.h': '''
+typedef unsigned int size_t; typedef long off_t;
+#define PROT_READ 1
+#define MAP_PRIVATE 2
+#define MAP_SHARED 1
+#define MAP_FAILED ((void *)-1)
+void *mmap(void *, size_t, int, int, int, off_t); int munmap(void *, size_t);
+''',
+
+  'sys/stat.h': '''
+struct stat { long st_size; };
+int fstat(int, struct stat *);
+'''
+}
+
+# ------------------------------------------------------------------------------------------------------------------------------------------------------
+# Write the AVR C library headers in a given folder
+# ------------------------------------------------------------------------------------------------------------------------------------------------------
+def writeAvrHeaders(folder):
+
+  for name, text in AVR_HEADERS.items():
+
+    path = os.path.join(folder, name)
+    os.makedirs(os.path.dirname(path), exist_ok=True)
+    with open(path, 'w') as header: header.write('#pragma once\n' + text)
+
+# ------------------------------------------------------------------------------------------------------------------------------------------------------
+# Return the type of an integer operand after the integer promotions of the AVR target
+# ------------------------------------------------------------------------------------------------------------------------------------------------------
+def promotedType(typeName):
+
+  if typeName == 'unsigned short': return 'unsigned int'
+  if typeName in ('bool', 'char', 'signed char', 'unsigned char', 'short'): return 'int'
+  return typeName
+
+# ------------------------------------------------------------------------------------------------------------------------------------------------------
+# Return the common type of two integer operands on the AVR target (the usual arithmetic conversions)
+# ------------------------------------------------------------------------------------------------------------------------------------------------------
+def commonType(leftType, rightType):
+
+  leftType, rightType = promotedType(leftType), promotedType(rightType)
+  if leftType == rightType or leftType not in TYPE_RANKS or rightType not in TYPE_RANKS: return leftType
+
+  leftUnsigned, rightUnsigned = leftType.startswith('unsigned'), rightType.startswith('unsigned')
+  if leftUnsigned == rightUnsigned: return leftType if TYPE_RANKS[leftType] >= TYPE_RANKS[rightType] else rightType
+
+  unsignedType, signedType = (leftType, rightType) if leftUnsigned else (rightType, leftType)
+  if TYPE_RANKS[unsignedType] >= TYPE_RANKS[signedType]: return unsignedType
+  return signedType                    # The signed type is wider, like long and unsigned int on the AVR target
+
+# ------------------------------------------------------------------------------------------------------------------------------------------------------
+# Rewrite a source file with the AVR integer widths. Returns the rewritten source and the number of rewritten and skipped operations.
+# ------------------------------------------------------------------------------------------------------------------------------------------------------
+def rewriteSource(path, clangArgs):
+
+  path = os.path.abspath(path)
+  unit = ci.Index.create().parse(path, args=['-target', 'avr', '-x', 'c++', '-std=gnu++11'] + clangArgs)
+  errors = [diagnostic for diagnostic in unit.diagnostics if diagnostic.severity >= ci.Diagnostic.Error]
+  for error in errors: print(error, file=sys.stderr)
+  if errors: sys.exit(1)
+
+  source = open(path, 'rb').read()
+  edits = []                           # Casts to insert : (offset, extent length, order, text)
+  counts = {'rewritten': 0, 'skipped': 0}
+
+  def canonicalType(cursor):
+    return cursor.type.get_canonical().spelling
+
+  def inSource(cursor):
+    extent = cursor.extent
+    return extent.start.file and extent.start.file.name == path and extent.end.file and extent.end.file.name == path and \
+           extent.start.offset < extent.end.offset
+
+  def cast(cursor, hostType):
+
+    # Pointers keep their width. The casts of a same extent are nested in the order they are made : the operand casts of the parent operation go
+    # outside the result cast of the operation itself.
+    if cursor.type.get_canonical().kind == ci.TypeKind.POINTER: return
+    start, stop = cursor.extent.start.offset, cursor.extent.end.offset
+    edits.append((start, start - stop, len(edits), '(' + hostType + ')('))
+    edits.append((stop, stop - start, -len(edits), ')'))
+
+  def operatorText(cursor, left, right):
+
+    # The operator is the text between the operands, unless the expression comes from a macro body
+    if left.extent.start.offset != cursor.extent.start.offset or right.extent.end.offset != cursor.extent.end.offset or \
+       left.extent.end.offset > right.extent.start.offset: return None
+    text = source[left.extent.end.offset:right.extent.start.offset].decode().strip()
+    operators = ARITHMETIC_OPERATORS | SHIFT_OPERATORS | COMPARISON_OPERATORS | OTHER_OPERATORS
+    return text if text in operators or (text[-1:] == '=' and text[:-1] in ARITHMETIC_OPERATORS | SHIFT_OPERATORS) else None
+
+  def visit(cursor):
+
+    kind = cursor.kind
+    if kind in (ci.CursorKind.BINARY_OPERATOR, ci.CursorKind.COMPOUND_ASSIGNMENT_OPERATOR) and inSource(cursor):
+
+      operands = list(cursor.get_children())
+      if len(operands) == 2 and inSource(operands[0]) and inSource(operands[1]):
+
+        operator = operatorText(cursor, operands[0], operands[1])
+        resultType = canonicalType(cursor)
+        leftType, rightType = canonicalType(operands[0]), canonicalType(operands[1])
+
+        if operator is None:
+          counts['skipped'] += 1
+        elif kind == ci.CursorKind.COMPOUND_ASSIGNMENT_OPERATOR:
+          operationType = promotedType(leftType) if operator[:-1] in SHIFT_OPERATORS else commonType(leftType, rightType)
+          if operationType in HOST_TYPES:
+            cast(operands[1], HOST_TYPES[operationType])
+            counts['rewritten'] += 1
+        elif operator in ARITHMETIC_OPERATORS and resultType in HOST_TYPES:
+          cast(cursor, HOST_TYPES[resultType])
+          cast(operands[0], HOST_TYPES[resultType])
+          cast(operands[1], HOST_TYPES[resultType])
+          counts['rewritten'] += 1
+        elif operator in SHIFT_OPERATORS and resultType in HOST_TYPES:
+          cast(cursor, HOST_TYPES[resultType])
+          cast(operands[0], HOST_TYPES[resultType])
+          counts['rewritten'] += 1
+        elif operator in COMPARISON_OPERATORS and commonType(leftType, rightType) in HOST_TYPES:
+          cast(operands[0], HOST_TYPES[commonType(leftType, rightType)])
+          cast(operands[1], HOST_TYPES[commonType(leftType, rightType)])
+          counts['rewritten'] += 1
+
+    elif kind == ci.CursorKind.UNARY_OPERATOR and inSource(cursor) and canonicalType(cursor) in HOST_TYPES:
+
+      # Prefix - and ~ only : the operator is the first token and the operand ends the expression
+      tokens = [token.spelling for token in cursor.get_tokens()]
+      operands = list(cursor.get_children())
+      if tokens and tokens[0] in ('-', '~') and len(operands) == 1 and inSource(operands[0]) and \
+         operands[0].extent.start.offset > cursor.extent.start.offset and operands[0].extent.end.offset == cursor.extent.end.offset:
+        cast(cursor, HOST_TYPES[canonicalType(cursor)])
+        cast(operands[0], HOST_TYPES[canonicalType(cursor)])
+        counts['rewritten'] += 1
+
+    elif kind == ci.CursorKind.CONDITIONAL_OPERATOR and inSource(cursor) and canonicalType(cursor) in HOST_TYPES and \
+         '?' in [token.spelling for token in cursor.get_tokens()]:
+      cast(cursor, HOST_TYPES[canonicalType(cursor)])
+      counts['rewritten'] += 1
+
+    for child in cursor.get_children(): visit(child)
+
+  visit(unit.cursor)
+
+  rewritten = bytearray()
+  position = 0
+  for offset, length, order, text in sorted(edits):
+    rewritten += source[position:offset] + text.encode()
+    position = offset
+  rewritten += source[position:]
+
+  return bytes(rewritten), counts
+
+# ------------------------------------------------------------------------------------------------------------------------------------------------------
+# ARCEIntWidth entry point : ARCEIntWidth.py <source file> [clang arguments]
+# ------------------------------------------------------------------------------------------------------------------------------------------------------
+def main():
+
+  if len(sys.argv) < 2:
+    print('Usage : python3 ARCEIntWidth.py <source file> [clang arguments] > <rewritten source file>', file=sys.stderr)
+    sys.exit(2)
+
+  with tempfile.TemporaryDirectory() as headersFolder:
+
+    writeAvrHeaders(headersFolder)
+    sourceFolder = os.path.dirname(os.path.abspath(sys.argv[1]))
+    clangArgs = ['-DARCE_HOST', '-DARCE_PROFILE', '-Dabs=arceAbs', '-ffreestanding', '-nostdlibinc', '-isystem', headersFolder, '-I', sourceFolder]
+    rewritten, counts = rewriteSource(sys.argv[1], clangArgs + sys.argv[2:])
+
+  sys.stdout.buffer.write(rewritten)
+  print('%d operations rewritten, %d skipped (macro bodies)' % (counts['rewritten'], counts['skipped']), file=sys.stderr)
+
+main()